@@ -0,0 +1,160 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <imgui.h>
+#include <imgui_impl_opengl3.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+#include "imgui_renderer.h"
+
+// Renders a synthetic UI of about 50k vertices with the stock OpenGL3 backend
+// and with ImGuiRenderer. "submit" is the CPU time of the render call alone,
+// "frame" adds glFinish so driver stalls and GPU time are included.
+// Run from the repository root so the shaders are found.
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+const unsigned int WARMUP_FRAMES = 60;
+const unsigned int FRAMES = 600;
+
+// 8 windows x 50 clip rects x 31 rects x 4 vertices = 49600 vertices
+const int WINDOWS = 8;
+const int CLIP_RECTS = 50;
+const int RECTS_PER_CLIP = 31;
+
+struct Result {
+    double submitMs;
+    double frameMs;
+};
+
+std::string readFile(const char* path) {
+    std::ifstream stream(path);
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    return buffer.str();
+}
+
+void buildUi() {
+    const float windowWidth = static_cast<float>(WIDTH) / WINDOWS;
+    for (int w = 0; w < WINDOWS; w++) {
+        ImGui::SetNextWindowPos(ImVec2(w * windowWidth, 0));
+        ImGui::SetNextWindowSize(ImVec2(windowWidth, static_cast<float>(HEIGHT)));
+        ImGui::Begin(("bench " + std::to_string(w)).c_str(), nullptr, ImGuiWindowFlags_NoDecoration);
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float clipHeight = (HEIGHT - 20.0f) / CLIP_RECTS;
+        for (int clip = 0; clip < CLIP_RECTS; clip++) {
+            const ImVec2 clipMin(origin.x, origin.y + clip * clipHeight);
+            const ImVec2 clipMax(origin.x + windowWidth - 20, clipMin.y + clipHeight);
+            drawList->PushClipRect(clipMin, clipMax, true);
+            for (int i = 0; i < RECTS_PER_CLIP; i++) {
+                const ImVec2 min(clipMin.x + i * 5.0f, clipMin.y + (i % 4));
+                const ImVec2 max(min.x + 4, clipMax.y - 1);
+                drawList->AddRectFilled(min, max, IM_COL32(40 + i * 6, 255 - clip * 4, 128, 200));
+            }
+            drawList->PopClipRect();
+        }
+        ImGui::End();
+    }
+}
+
+template<typename Render>
+Result bench(GLFWwindow* window, Render render) {
+    Result result = {};
+    for (unsigned int frame = 0; frame < WARMUP_FRAMES + FRAMES; frame++) {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui::NewFrame();
+        buildUi();
+        ImGui::Render();
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        auto start = steady_clock::now();
+        render(ImGui::GetDrawData());
+        auto submitted = steady_clock::now();
+        glFinish();
+        auto finished = steady_clock::now();
+        glfwSwapBuffers(window);
+
+        if (frame >= WARMUP_FRAMES) {
+            result.submitMs += duration<double, std::milli>(submitted - start).count();
+            result.frameMs += duration<double, std::milli>(finished - start).count();
+        }
+    }
+    result.submitMs /= FRAMES;
+    result.frameMs /= FRAMES;
+    return result;
+}
+
+int main() {
+    if (!glfwInit()) {
+        std::fprintf(stderr, "Could not initialize GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    auto window = glfwCreateWindow(WIDTH, HEIGHT, "imgui_bench", nullptr, nullptr);
+    if (!window) {
+        std::fprintf(stderr, "Could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::fprintf(stderr, "Could not initialize GLAD\n");
+        return 1;
+    }
+    glViewport(0, 0, WIDTH, HEIGHT);
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(static_cast<float>(WIDTH), static_cast<float>(HEIGHT));
+    io.DeltaTime = 1.0f / 60;
+    io.IniFilename = nullptr;
+    ImGui_ImplOpenGL3_Init();
+
+    GlState gl;
+    ImGuiRenderer renderer;
+    auto vertexSource = readFile("shaders/imgui_vertex.glsl");
+    auto fragmentSource = readFile("shaders/imgui_fragment.glsl");
+    if (!renderer.init(gl, vertexSource.c_str(), fragmentSource.c_str())) {
+        std::fprintf(stderr, "Could not create the ImGui renderer\n");
+        return 1;
+    }
+
+    auto stock = bench(window, [&](ImDrawData* drawData) {
+        ImGui_ImplOpenGL3_RenderDrawData(drawData);
+        // The stock backend restores its bindings, but not through GlState
+        gl.invalidate();
+    });
+    auto streaming = bench(window, [&](ImDrawData* drawData) { renderer.render(gl, drawData); });
+
+    const ImDrawData* drawData = ImGui::GetDrawData();
+    std::printf(
+        "UI: %d vertices, %d indices, %d draw lists\n",
+        drawData->TotalVtxCount, drawData->TotalIdxCount, drawData->CmdListsCount
+    );
+    std::printf("stock:     submit %.3f ms, frame %.3f ms\n", stock.submitMs, stock.frameMs);
+    std::printf(
+        "streaming: submit %.3f ms, frame %.3f ms (%s)\n", streaming.submitMs, streaming.frameMs,
+        renderer.isPersistent() ? "persistent" : "unsynchronized map"
+    );
+
+    renderer.destroy();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+    gpuResources().shutdown();
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+
+// Writes a grid of about SIZE MiB (first argument, default 256) as OBJ, ASCII
+// PLY and binary PLY into /tmp, then imports each file on one thread and on
+// all cores. The read column is a plain pass over the mapped file, the upper
+// bound for any parser on this machine. Files are read once before timing so
+// all runs see the page cache. The cache column opens and checks the binary
+// mesh cache written from the import, what later starts do instead.
+//
+// Small edge cases are parsed first and the bench fails if any gives the
+// wrong result. The rejected ones log their error.
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+const int RUNS = 3;
+
+// Vertex and index writers, one line or record per call
+struct Writer {
+    public:
+    explicit Writer(const char* path) : file(std::fopen(path, "wb")) {}
+    ~Writer() {
+        if (file)
+            std::fclose(file);
+    }
+
+    void text(const char* format, float x, float y, float z) {
+        char line[96];
+        const int length = std::snprintf(line, sizeof(line), format, x, y, z);
+        std::fwrite(line, 1, static_cast<size_t>(length), file);
+    }
+    void text(const char* format, unsigned a, unsigned b, unsigned c) {
+        char line[96];
+        const int length = std::snprintf(line, sizeof(line), format, a, b, c);
+        std::fwrite(line, 1, static_cast<size_t>(length), file);
+    }
+    template<typename T>
+    void binary(T value) {
+        std::fwrite(&value, sizeof(value), 1, file);
+    }
+
+    FILE* file;
+};
+
+enum class Format { Obj, PlyAscii, PlyBinary };
+
+// cells x cells quads of two triangles, about 75 bytes of OBJ text per quad
+void writeGrid(const char* path, Format format, unsigned cells) {
+    Writer out(path);
+    const unsigned side = cells + 1;
+    const unsigned vertices = side * side;
+    const unsigned triangles = cells * cells * 2;
+    if (format != Format::Obj) {
+        std::fprintf(
+            out.file,
+            "ply\nformat %s 1.0\nelement vertex %u\nproperty float x\nproperty float y\nproperty float z\n"
+            "element face %u\nproperty list uchar int vertex_indices\nend_header\n",
+            format == Format::PlyAscii ? "ascii" : "binary_little_endian", vertices, triangles
+        );
+    }
+    for (unsigned y = 0; y < side; y++) {
+        for (unsigned x = 0; x < side; x++) {
+            const float px = static_cast<float>(x) / cells * 2 - 1;
+            const float py = static_cast<float>(y) / cells * 2 - 1;
+            const float pz = 0.1f * std::sin(px * 7) * std::cos(py * 5);
+            if (format == Format::Obj) {
+                out.text("v %.6f %.6f %.6f\n", px, py, pz);
+            } else if (format == Format::PlyAscii) {
+                out.text("%.6f %.6f %.6f\n", px, py, pz);
+            } else {
+                out.binary(px);
+                out.binary(py);
+                out.binary(pz);
+            }
+        }
+    }
+    const unsigned base = format == Format::Obj ? 1 : 0;
+    const char* face = format == Format::Obj ? "f %u %u %u\n" : "3 %u %u %u\n";
+    for (unsigned y = 0; y < cells; y++) {
+        for (unsigned x = 0; x < cells; x++) {
+            const unsigned v = y * side + x + base;
+            const unsigned quad[2][3] = {{v, v + 1, v + side + 1}, {v, v + side + 1, v + side}};
+            for (const auto& triangle : quad) {
+                if (format == Format::PlyBinary) {
+                    out.binary(static_cast<unsigned char>(3));
+                    for (unsigned index : triangle)
+                        out.binary(static_cast<int>(index));
+                } else {
+                    out.text(face, triangle[0], triangle[1], triangle[2]);
+                }
+            }
+        }
+    }
+}
+
+// Input the parsers must accept with `triangles` triangles, or reject (-1)
+struct ParserCase {
+    const char* name;
+    bool obj;
+    const char* text;
+    size_t size; // 0 for strlen(text), binary text contains zeros
+    int triangles;
+};
+
+const char PLY_BINARY_NO_NEWLINE[] =
+    "ply\nformat binary_little_endian 1.0\nelement vertex 3\nproperty float x\nproperty float y\n"
+    "property float z\nend_header";
+
+const ParserCase PARSER_CASES[] = {
+    {"obj with w", true, "v 0 0 0 1\nv 1 0 0 1.0\nv 0 1 0 0.5\nf 1 2 3\n", 0, 1},
+    {"obj with color", true, "v 0 0 0 1 0 0\nv 1 0 0 0 1 0\nv 0 1 0 0 0 1\nf 1 2 3\n", 0, 1},
+    {"obj comments", true, "v 0 0 0 # origin\nv 1 0 0\nv 0 1 0 1# w\nf 1/1 2/2 3/3# face\nf 1 2 3 #\n", 0, 2},
+    {"obj two extras", true, "v 0 0 0 1 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n", 0, -1},
+    {"obj four extras", true, "v 0 0 0 1 0 0 1\nv 1 0 0\nv 0 1 0\nf 1 2 3\n", 0, -1},
+    {"ply ascii empty body", false, "ply\nformat ascii 1.0\nelement vertex 0\nproperty float x\nproperty float y\n"
+        "property float z\nend_header", 0, 0},
+    {"ply ascii no body", false, "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\n"
+        "property float z\nend_header\r", 0, -1},
+    {"ply binary no body", false, PLY_BINARY_NO_NEWLINE, sizeof(PLY_BINARY_NO_NEWLINE) - 1, -1},
+    {"ply ascii huge list", false, "ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nproperty float y\n"
+        "property float z\nelement face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0\n1 0 0\n0 1 0\n"
+        "4000000000000000000 0 1 2\n", 0, -1},
+};
+
+bool checkParsers() {
+    bool ok = true;
+    for (const auto& test : PARSER_CASES) {
+        // A copy sized to the text, so reads past the end are caught by sanitizers
+        const size_t size = test.size ? test.size : std::strlen(test.text);
+        const std::vector<char> text(test.text, test.text + size);
+        MeshData mesh;
+        const bool parsed = test.obj ? parseObj(text.data(), size, mesh, 1) : parsePly(text.data(), size, mesh, 1);
+        const int triangles = parsed ? static_cast<int>(mesh.indices.size() / 3) : -1;
+        if (triangles != test.triangles) {
+            std::fprintf(stderr, "Parser check %s: %d triangles, expected %d\n", test.name, triangles, test.triangles);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Best of RUNS, in ms
+template<typename Function>
+double bestMs(Function fn) {
+    double best = 1e30;
+    for (int run = 0; run < RUNS; run++) {
+        const auto start = steady_clock::now();
+        fn();
+        best = std::min(best, duration<double, std::milli>(steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+bool bench(const char* name, const char* path, int cores) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    volatile unsigned sink = 0;
+    const double readMs = bestMs([&]() {
+        unsigned sum = 0;
+        for (size_t i = 0; i < file.size(); i++)
+            sum += static_cast<unsigned char>(file.data()[i]);
+        sink = sink + sum;
+    });
+
+    MeshData mesh;
+    ImportStats stats = {};
+    bool ok = true;
+    const double oneMs = bestMs([&]() { ok &= importMesh(path, mesh, &stats, 1); });
+    const double allMs = bestMs([&]() { ok &= importMesh(path, mesh, &stats, cores); });
+    const std::string cachePath = meshCachePath(path);
+    if (!ok || !writeMeshCache(cachePath.c_str(), path, mesh))
+        return false;
+    MeshCache cache;
+    const double cacheMs = bestMs([&]() { ok &= cache.open(cachePath.c_str(), path); });
+    cache.close();
+    std::remove(cachePath.c_str());
+    if (!ok)
+        return false;
+
+    const double gb = file.size() / 1e9;
+    std::printf(
+        "%-10s %8.1f %10zu %10zu %9.2f %9.2f %9.2f %8.0f %8.0f %8.1f\n", name, file.size() / (1024.0 * 1024.0),
+        stats.vertices, stats.triangles, gb / (readMs / 1000), gb / (oneMs / 1000), gb / (allMs / 1000), oneMs, allMs,
+        cacheMs
+    );
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const double mib = argc > 1 ? std::atof(argv[1]) : 256;
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    // OBJ text for the grid is about 75 bytes per cell
+    const auto cells = static_cast<unsigned>(std::sqrt(mib * 1024 * 1024 / 75));
+
+    const struct {
+        const char* name;
+        const char* path;
+        Format format;
+    } files[] = {
+        {"obj", "/tmp/import_bench.obj", Format::Obj},
+        {"ply ascii", "/tmp/import_bench_ascii.ply", Format::PlyAscii},
+        {"ply binary", "/tmp/import_bench_binary.ply", Format::PlyBinary},
+    };
+
+    if (!checkParsers())
+        return 1;
+
+    std::printf("%u x %u grid, %d cores, best of %d runs\n\n", cells, cells, cores, RUNS);
+    std::printf(
+        "%-10s %8s %10s %10s %9s %9s %9s %8s %8s %8s\n", "format", "MiB", "vertices", "triangles", "read GB/s",
+        "1 thr", "all thr", "1 thr ms", "all ms", "cache ms"
+    );
+    int status = 0;
+    for (const auto& file : files) {
+        writeGrid(file.path, file.format, cells);
+        if (!bench(file.name, file.path, cores)) {
+            std::fprintf(stderr, "Could not import %s\n", file.path);
+            status = 1;
+        }
+        std::remove(file.path);
+    }
+    return status;
+}
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "logs.h"
+
+// Measures the cost of a log call on the calling thread. Output goes to
+// /dev/null so only the hot path (argument capture + ring push) is timed.
+// Built with LOG_LEVEL=LOG_LEVEL_INFO, so the debug row is the cost of a
+// compiled out call.
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+const unsigned int ITERATIONS = 200 * 1024;
+
+const unsigned int BATCH_SIZE = 1024;
+
+double benchInfo(unsigned int iterations) {
+    double total = 0;
+    for (unsigned int batch = 0; batch < iterations; batch += BATCH_SIZE) {
+        auto start = steady_clock::now();
+        for (unsigned int i = batch; i < batch + BATCH_SIZE; i++) {
+            info("Frame " << i << " took " << 16.6f << "ms");
+        }
+        total += duration<double, std::nano>(steady_clock::now() - start).count();
+        // Let the logger thread catch up (untimed) so we measure pushes, not drops
+        Logger::flush();
+    }
+    return total / iterations;
+}
+
+int main() {
+    if (!std::freopen("/dev/null", "w", stdout)) {
+        std::fprintf(stderr, "Could not redirect stdout\n");
+        return 1;
+    }
+
+    // Warm up the thread-local buffer, ring and logger thread
+    benchInfo(1000);
+    Logger::flush();
+
+    std::fprintf(stderr, "info, 1 thread:  %.1f ns/call\n", benchInfo(ITERATIONS));
+    Logger::flush();
+
+    const unsigned int threadCount = 4;
+    std::vector<double> results(threadCount);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+        threads.emplace_back([&results, t] { results[t] = benchInfo(ITERATIONS); });
+    for (auto& thread : threads)
+        thread.join();
+    Logger::flush();
+
+    double sum = 0;
+    for (auto result : results) sum += result;
+    std::fprintf(stderr, "info, %u threads: %.1f ns/call\n", threadCount, sum / threadCount);
+
+    auto start = steady_clock::now();
+    for (unsigned int i = 0; i < BATCH_SIZE; i++) {
+        debug("Frame " << i << " took " << 16.6f << "ms");
+    }
+    auto disabled = duration<double, std::nano>(steady_clock::now() - start).count() / BATCH_SIZE;
+    std::fprintf(
+        stderr, "debug, %s (LOG_LEVEL=%d): %.1f ns/call\n", LOG_LEVEL > LOG_LEVEL_DEBUG ? "compiled out" : "enabled",
+        LOG_LEVEL, disabled
+    );
+    std::fprintf(stderr, "dropped records: %llu\n", (unsigned long long)Logger::droppedRecords());
+
+    return 0;
+}
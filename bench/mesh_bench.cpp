@@ -0,0 +1,216 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_state.h"
+#include "gpu_buffer_allocator.h"
+#include "gpu_resources.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "program.h"
+
+// Welds the sample meshes on one thread and on all cores, then draws each as
+// the loaded triangle soup and as the welded indexed mesh. The second table
+// optimizes the welded meshes for the vertex cache, reporting ACMR/ATVR,
+// throughput on one thread and on all cores, and draw times before and after.
+// Draw times are wall time per draw of INSTANCES instances, averaged over
+// DRAWS draws ending in glFinish. Run from the repository root so the shaders
+// are found. The last table loads a scene of SCENE_MESHES meshes from binary
+// caches, split into mapping and checking the files and uploading them.
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+const int SIZE = 512;
+const int DRAWS = 20;
+const int INSTANCES = 4;
+const int SCENE_MESHES = 100;
+
+std::string readFile(const char* path) {
+    std::ifstream stream(path);
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    return buffer.str();
+}
+
+double drawMs(GlState& gl, const Mesh& mesh) {
+    mesh.draw(gl, INSTANCES);
+    glFinish();
+    auto start = steady_clock::now();
+    for (int i = 0; i < DRAWS; i++)
+        mesh.draw(gl, INSTANCES);
+    glFinish();
+    return duration<double, std::milli>(steady_clock::now() - start).count() / DRAWS;
+}
+
+struct Sample {
+    const char* name;
+    MeshData welded;
+};
+
+void benchWeld(GlState& gl, GpuBufferAllocator& buffers, Sample& sample, const MeshData& soup) {
+    const char* name = sample.name;
+    MeshData serial = soup;
+    const WeldStats one = weldVertices(serial, 1);
+    MeshData& welded = sample.welded;
+    welded = soup;
+    const WeldStats all = weldVertices(welded);
+
+    Mesh soupMesh;
+    Mesh indexedMesh;
+    soupMesh.upload(gl, buffers, soup, name);
+    indexedMesh.upload(gl, buffers, welded, name);
+    const double soupMs = drawMs(gl, soupMesh);
+    const double indexedMs = drawMs(gl, indexedMesh);
+
+    std::printf(
+        "%-12s %9zu %9zu %5.1f%% %8.2f %8.2f (%2d) %9.3f %9.3f %6zu %6zu\n", name, one.inputVertices, one.outputVertices,
+        100.0 - 100.0 * one.outputVertices / one.inputVertices, one.ms, all.ms, all.threads, soupMs, indexedMs,
+        soupMesh.getSize() / 1024, indexedMesh.getSize() / 1024
+    );
+    soupMesh.destroy();
+    indexedMesh.destroy();
+}
+
+void benchOptimize(GlState& gl, GpuBufferAllocator& buffers, const Sample& sample) {
+    MeshData serial = sample.welded;
+    const MeshOptimizeStats one = optimizeMesh(serial, 1);
+    MeshData optimized = sample.welded;
+    const MeshOptimizeStats all = optimizeMesh(optimized);
+
+    Mesh before;
+    Mesh after;
+    before.upload(gl, buffers, sample.welded, sample.name);
+    after.upload(gl, buffers, optimized, sample.name);
+    const double beforeMs = drawMs(gl, before);
+    const double afterMs = drawMs(gl, after);
+
+    std::printf(
+        "%-12s %9zu %5.2f %5.2f %5.2f %5.2f %8.1f %8.1f (%2d) %9.3f %9.3f\n", sample.name, one.triangles,
+        one.before.acmr, one.after.acmr, one.before.atvr, one.after.atvr, one.triangles / (one.ms * 1000.0),
+        all.triangles / (all.ms * 1000.0), all.threads, beforeMs, afterMs
+    );
+    before.destroy();
+    after.destroy();
+}
+
+// Caches of the small samples, written to /tmp, then loaded the way startup
+// does. The files are in the page cache, as on any start but the first.
+bool benchCacheStartup(GlState& gl, GpuBufferAllocator& buffers, const Sample* samples, size_t sampleCount) {
+    const char* source = "/tmp/mesh_bench_source";
+    std::fclose(std::fopen(source, "w"));
+    std::vector<std::string> paths;
+    for (int i = 0; i < SCENE_MESHES; i++) {
+        paths.push_back("/tmp/mesh_bench_" + std::to_string(i) + ".meshcache");
+        if (!writeMeshCache(paths.back().c_str(), source, samples[i % sampleCount].welded))
+            return false;
+    }
+
+    std::vector<MeshCache> caches(SCENE_MESHES);
+    std::vector<Mesh> meshes(SCENE_MESHES);
+    glFinish();
+    const auto start = steady_clock::now();
+    for (int i = 0; i < SCENE_MESHES; i++) {
+        if (!caches[i].open(paths[i].c_str(), source))
+            return false;
+    }
+    const auto opened = steady_clock::now();
+    size_t bytes = 0;
+    for (int i = 0; i < SCENE_MESHES; i++) {
+        meshes[i].upload(gl, buffers, caches[i].view(), paths[i].c_str());
+        bytes += meshes[i].getSize();
+    }
+    glFinish();
+    const auto uploaded = steady_clock::now();
+
+    const double openMs = duration<double, std::milli>(opened - start).count();
+    const double uploadMs = duration<double, std::milli>(uploaded - opened).count();
+    std::printf(
+        "%6d %8.1f %9.2f %9.2f %7.1f%% %8.2f\n", SCENE_MESHES, bytes / (1024.0 * 1024.0), openMs, uploadMs,
+        100 * uploadMs / (openMs + uploadMs), bytes / (uploadMs * 1e6)
+    );
+    for (int i = 0; i < SCENE_MESHES; i++) {
+        meshes[i].destroy();
+        caches[i].close();
+        std::remove(paths[i].c_str());
+    }
+    std::remove(source);
+    return true;
+}
+
+int main() {
+    if (!glfwInit()) {
+        std::fprintf(stderr, "Could not initialize GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    auto window = glfwCreateWindow(SIZE, SIZE, "mesh_bench", nullptr, nullptr);
+    if (!window) {
+        std::fprintf(stderr, "Could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::fprintf(stderr, "Could not initialize GLAD\n");
+        return 1;
+    }
+
+    GlState gl;
+    {
+        Program program;
+        const auto vertexSource = readFile("shaders/vertex.glsl");
+        const auto fragmentSource = readFile("shaders/fragment.glsl");
+        if (!program.registerShader(vertexSource.c_str(), Program::ShaderType::Vertex)
+            || !program.registerShader(fragmentSource.c_str(), Program::ShaderType::Fragment)
+            || !program.registerProgram()) {
+            std::fprintf(stderr, "Could not build the scene program, run from the repository root\n");
+            return 1;
+        }
+        gl.useProgram(program.getId());
+        glUniform1i(glGetUniformLocation(program.getId(), "instanceCount"), INSTANCES);
+        glViewport(0, 0, SIZE, SIZE);
+
+        GpuBufferAllocator buffers("bench meshes", 64 << 20);
+        std::printf(
+            "%-12s %9s %9s %6s %8s %8s %4s %9s %9s %6s %6s\n", "mesh", "soup", "welded", "saved", "weld ms", "parallel",
+            "", "soup ms", "index ms", "KiB", "KiB"
+        );
+        Sample samples[] = {{"sphere", {}}, {"grid", {}}, {"sphere big", {}}, {"grid big", {}}};
+        benchWeld(gl, buffers, samples[0], sphereSoup(192, 256));
+        benchWeld(gl, buffers, samples[1], gridSoup(256));
+        benchWeld(gl, buffers, samples[2], sphereSoup(512, 1024));
+        benchWeld(gl, buffers, samples[3], gridSoup(1024));
+
+        std::printf(
+            "\n%-12s %9s %5s %5s %5s %5s %8s %8s %4s %9s %9s\n", "mesh", "triangles", "ACMR", "opt", "ATVR", "opt",
+            "Mtri/s", "parallel", "", "before ms", "after ms"
+        );
+        for (const auto& sample : samples)
+            benchOptimize(gl, buffers, sample);
+
+        std::printf("\n%6s %8s %9s %9s %8s %8s\n", "meshes", "MiB", "open ms", "upload ms", "upload", "GB/s");
+        const bool cached = benchCacheStartup(gl, buffers, samples, 2);
+        buffers.destroy();
+        if (!cached) {
+            std::fprintf(stderr, "Could not write or load the mesh caches in /tmp\n");
+            gpuResources().shutdown();
+            glfwTerminate();
+            return 1;
+        }
+    }
+
+    gpuResources().shutdown();
+    glfwTerminate();
+    return 0;
+}
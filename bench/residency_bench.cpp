@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+#include "residency.h"
+
+// Streams a working set through a GPU budget far smaller than the data:
+// BUFFERS buffers of BUFFER_SIZE bytes, WORKING_SET of them in use at a time,
+// sliding along every SLIDE_FRAMES frames. Checks that tracked memory never
+// exceeds the budget and that reloaded buffers hold the right contents, exits
+// with 1 otherwise. Works on llvmpipe (LIBGL_ALWAYS_SOFTWARE=1).
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+const uint32_t BUFFERS = 64;
+const size_t BUFFER_SIZE = 1 << 20;
+const size_t BUDGET = 16 << 20;
+const size_t LOAD_BYTES_PER_FRAME = 4 << 20;
+const uint32_t WORKING_SET = 8;
+const uint32_t SLIDE_FRAMES = 20;
+const uint32_t FRAMES = 1200;
+
+struct Source {
+    uint32_t index;
+};
+
+uint32_t pattern(uint32_t index, size_t word) {
+    return index * 2654435761u ^ static_cast<uint32_t>(word);
+}
+
+bool loadSource(void* userData, void* destination, size_t size) {
+    const auto source = static_cast<const Source*>(userData);
+    auto words = static_cast<uint32_t*>(destination);
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++)
+        words[i] = pattern(source->index, i);
+    return true;
+}
+
+int main() {
+    if (!glfwInit()) {
+        std::fprintf(stderr, "Could not initialize GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    auto window = glfwCreateWindow(64, 64, "residency_bench", nullptr, nullptr);
+    if (!window) {
+        std::fprintf(stderr, "Could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::fprintf(stderr, "Could not initialize GLAD\n");
+        return 1;
+    }
+
+    GlState gl;
+    ResidencyManager residency;
+    residency.setLimits(BUDGET, LOAD_BYTES_PER_FRAME);
+    std::vector<Source> sources(BUFFERS);
+    std::vector<uint32_t> handles(BUFFERS);
+    for (uint32_t i = 0; i < BUFFERS; i++) {
+        sources[i].index = i;
+        // Every fourth buffer matters more and jumps the load queue
+        handles[i] = residency.add(BUFFER_SIZE, i % 4 == 0 ? 1 : 0, loadSource, &sources[i]);
+    }
+
+    size_t peakBytes = 0;
+    uint64_t uses = 0;
+    uint64_t misses = 0;
+    uint32_t corrupt = 0;
+    auto start = steady_clock::now();
+    for (uint32_t frame = 0; frame < FRAMES; frame++) {
+        gpuResources().beginFrame(frame);
+        residency.update(gl, frame);
+        peakBytes = std::max(peakBytes, residency.stats().usedBytes);
+
+        const uint32_t first = frame / SLIDE_FRAMES;
+        for (uint32_t i = 0; i < WORKING_SET; i++) {
+            const uint32_t index = (first + i) % BUFFERS;
+            const GLuint buffer = residency.use(handles[index]);
+            uses++;
+            if (!buffer) {
+                misses++;
+                continue;
+            }
+            // Spot check the last word, it was written last
+            const size_t word = BUFFER_SIZE / sizeof(uint32_t) - 1;
+            uint32_t value = 0;
+            gl.bindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, word * sizeof(uint32_t), sizeof(value), &value);
+            if (value != pattern(index, word))
+                corrupt++;
+        }
+    }
+    glFinish();
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+
+    const auto stats = residency.stats();
+    std::printf("%u frames in %.2f s, budget %zu MiB\n", FRAMES, seconds, BUDGET >> 20);
+    std::printf(
+        "loads %llu, evictions %llu, uses %llu, not resident %llu, peak %.1f MiB\n",
+        static_cast<unsigned long long>(stats.loads), static_cast<unsigned long long>(stats.evictions),
+        static_cast<unsigned long long>(uses), static_cast<unsigned long long>(misses), peakBytes / (1024.0 * 1024.0)
+    );
+
+    residency.destroy();
+    gpuResources().shutdown();
+    glfwTerminate();
+
+    if (peakBytes > BUDGET || corrupt > 0) {
+        std::fprintf(stderr, "FAILED: peak over budget or %u corrupt buffers\n", corrupt);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <chrono>
+
+#include <imgui.h>
+
+#include "dashboard.h"
+#include "frame_arena.h"
+#include "gpu_resources.h"
+#include "memory.h"
+
+namespace {
+
+constexpr double residentUpdateInterval = 0.5;
+constexpr float plotHeight = 60;
+
+double seconds() {
+    using std::chrono::duration;
+    return duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+Dashboard::Dashboard() {
+    frameTimes.reserve(reservedFrames);
+    gpuTimes.reserve(reservedFrames);
+    uploads.reserve(reservedFrames);
+}
+
+void Dashboard::record(const FrameStats& stats) {
+    float gpuMs = 0;
+    for (float ms : stats.gpuMs)
+        gpuMs += std::max(ms, 0.0f);
+    frameTimes.push(stats.frameMs);
+    gpuTimes.push(gpuMs);
+    uploads.push(stats.counters.bytesUploaded / 1024.0f);
+    renderTargetAllocations += stats.counters.renderTargetAllocations;
+
+    if (!visible)
+        return;
+    history[next] = stats;
+    next = (next + 1) % historySize;
+    count = std::min(count + 1, historySize);
+}
+
+float Dashboard::frameTimeAt(void* data, int index) {
+    auto dashboard = static_cast<Dashboard*>(data);
+    const int oldest = (dashboard->next - dashboard->count + historySize) % historySize;
+    return dashboard->history[(oldest + index) % historySize].frameMs;
+}
+
+// Min/max envelope of the last plotSpan samples, one bucket per pixel column
+void Dashboard::plot(const char* label, const TimeSeries& series, const char* unit) {
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    const size_t count = std::min<size_t>(plotSpan, series.size());
+    FrameVector<float> mins(static_cast<size_t>(width));
+    FrameVector<float> maxs(mins.size());
+    const size_t points = series.query(series.size() - count, count, mins.size(), mins.data(), maxs.data());
+
+    float top = 0;
+    for (size_t i = 0; i < points; i++)
+        top = std::max(top, maxs[i]);
+    const float scale = top > 0 ? plotHeight / (top * 1.1f) : 0;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + plotHeight), ImGui::GetColorU32(ImGuiCol_FrameBg));
+    const ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotLines);
+    const float step = points > 0 ? width / points : 0;
+    for (size_t i = 0; i < points; i++) {
+        const float x = origin.x + (i + 0.5f) * step;
+        const float high = origin.y + plotHeight - maxs[i] * scale;
+        // At least one pixel tall so flat stretches stay visible
+        const float low = std::max(origin.y + plotHeight - mins[i] * scale, high + 1);
+        drawList->AddLine(ImVec2(x, high), ImVec2(x, low), color, std::max(step, 1.0f));
+    }
+    ImGui::Dummy(ImVec2(width, plotHeight));
+    ImGui::Text("%s: %.2f %s (max %.2f %s)", label, series.latest(), unit, top, unit);
+}
+
+// Live objects per type in the registry, with the memory reported for them
+void Dashboard::drawGpuResources() {
+    if (!ImGui::TreeNode("GPU resources"))
+        return;
+    if (ImGui::BeginTable("resources", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Pending");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < static_cast<int>(GpuResourceType::Count); i++) {
+            const auto type = static_cast<GpuResourceType>(i);
+            const auto& stats = gpuResources().stats(type);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(gpuResourceTypeName(type));
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.pending);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.bytes / (1024.0 * 1024.0));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::TreePop();
+}
+
+// ImGui's pool: totals plus a table per size class
+void Dashboard::drawImGuiMemory(double allocationsPerSecond) {
+    const auto& pool = imguiPool();
+    ImGui::Text(
+        "ImGui memory: %.1f KiB in use, %.1f KiB reserved, %.0f allocations/s",
+        pool.bytesInUse() / 1024.0, pool.bytesReserved() / 1024.0, allocationsPerSecond
+    );
+    if (!ImGui::TreeNode("ImGui size classes"))
+        return;
+    if (ImGui::BeginTable("classes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Size");
+        ImGui::TableSetupColumn("In use");
+        ImGui::TableSetupColumn("Free");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < PoolAllocator::classCount; i++) {
+            const auto& sizeClass = pool.sizeClass(i);
+            if (sizeClass.allocations == 0)
+                continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", sizeClass.blockSize);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", sizeClass.blocksInUse);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", sizeClass.blocksFree);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(sizeClass.allocations));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text(
+        "Larger than %zu bytes: %llu allocations", PoolAllocator::maxPooledSize,
+        static_cast<unsigned long long>(pool.largeAllocations())
+    );
+    ImGui::TreePop();
+}
+
+void Dashboard::draw() {
+    if (showDemoWindow)
+        ImGui::ShowDemoWindow(&showDemoWindow);
+    if (!visible || count == 0)
+        return;
+
+    // Reading the RSS is a syscall, a couple of times a second is plenty
+    const double now = seconds();
+    if (now - lastResidentUpdate >= residentUpdateInterval) {
+        residentBytes = residentSetSize();
+        lastResidentUpdate = now;
+    }
+
+    const auto& last = history[(next - 1 + historySize) % historySize];
+    float total = 0;
+    float worst = 0;
+    int uiRedraws = 0;
+    int allocatingFrames = 0;
+    double imguiAllocations = 0;
+    for (int i = 0; i < count; i++) {
+        const float ms = frameTimeAt(this, i);
+        total += ms;
+        worst = std::max(worst, ms);
+        uiRedraws += history[i].counters.uiRedraws;
+        allocatingFrames += history[i].heap.allocations > 0;
+        imguiAllocations += history[i].imguiHeap.allocations;
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(380, 640), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Performance", &visible)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Frame %u: %.2f ms (avg %.2f ms, max %.2f ms)", last.frame, last.frameMs, total / count, worst);
+    const int recorded = std::max(static_cast<int>(frameTimes.size()), historySize);
+    ImGui::SliderInt("Frames shown", &plotSpan, historySize, recorded, "%d", ImGuiSliderFlags_Logarithmic);
+    plot("Frame", frameTimes, "ms");
+    plot("GPU", gpuTimes, "ms");
+    plot("Uploaded", uploads, "KiB");
+    const size_t historyBytes = frameTimes.memoryBytes() + gpuTimes.memoryBytes() + uploads.memoryBytes();
+    ImGui::TextDisabled("%zu frames of history, %.1f MiB reserved", frameTimes.size(), historyBytes / (1024.0 * 1024.0));
+
+    if (ImGui::BeginTable("phases", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < static_cast<int>(FramePhase::Count); i++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(framePhaseName(static_cast<FramePhase>(i)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", last.cpuMs[i]);
+            ImGui::TableNextColumn();
+            if (last.gpuMs[i] >= 0)
+                ImGui::Text("%.3f", last.gpuMs[i]);
+            else
+                ImGui::TextDisabled("-");
+        }
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("GPU timings are from frame %u", last.gpuFrame);
+    ImGui::Text(
+        "Blocked in swap: %.2f ms, input to present: %.2f ms",
+        last.cpuMs[static_cast<int>(FramePhase::Swap)], last.latencyMs
+    );
+
+    ImGui::Separator();
+    const auto& counters = last.counters;
+    ImGui::Text("Draw calls: %u", counters.drawCalls);
+    ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(counters.triangles));
+    ImGui::Text("Uploaded: %.1f KiB in %u calls", counters.bytesUploaded / 1024.0, counters.uploadCalls);
+    if (stagedUploads.totalBytes > 0) {
+        ImGui::Text(
+            "  staged: %.1f KiB from %u updates in %u copies, %.2f ms, %.1f KiB waiting", stagedUploads.bytes / 1024.0,
+            stagedUploads.uploads, stagedUploads.calls, stagedUploads.cpuMs, stagedUploads.pendingBytes / 1024.0
+        );
+    }
+    ImGui::Text("GL calls filtered: %u", counters.glCallsFiltered);
+    ImGui::Text("UI redraws: %d of the last %d frames", uiRedraws, count);
+    if (counters.outputWindows > 0) {
+        ImGui::Text(
+            "Output windows: %u, %.3f ms CPU each", counters.outputWindows,
+            last.cpuMs[static_cast<int>(FramePhase::Outputs)] / counters.outputWindows
+        );
+    }
+    ImGui::Text("Render target allocations: %llu", static_cast<unsigned long long>(renderTargetAllocations));
+    ImGui::Text(
+        "Heap allocations: %llu (%.1f KiB), %llu frees", static_cast<unsigned long long>(last.heap.allocations),
+        last.heap.bytes / 1024.0, static_cast<unsigned long long>(last.heap.frees)
+    );
+    ImGui::Text(
+        "  render thread %llu, frames allocating: %d of %d",
+        static_cast<unsigned long long>(last.threadHeap.allocations), allocatingFrames, count
+    );
+    drawImGuiMemory(total > 0 ? imguiAllocations * 1000 / total : 0);
+    ImGui::Text("Resident memory: %.1f MiB", residentBytes / (1024.0 * 1024.0));
+    drawGpuResources();
+    if (meshBuffers.pages > 0) {
+        ImGui::Text(
+            "Mesh buffers: %u allocations, %.1f of %.1f MiB in %d pages", meshBuffers.allocations,
+            meshBuffers.usedBytes / (1024.0 * 1024.0), meshBuffers.capacity / (1024.0 * 1024.0), meshBuffers.pages
+        );
+        ImGui::Text(
+            "  fragmentation %.0f%%, largest hole %.1f MiB, compaction moved %.1f MiB",
+            meshBuffers.fragmentation * 100, meshBuffers.largestFree / (1024.0 * 1024.0),
+            meshBuffers.bytesMoved / (1024.0 * 1024.0)
+        );
+    }
+    if (residency.budget > 0 || residency.streamable > 0) {
+        if (residency.budget > 0)
+            ImGui::Text(
+                "GPU budget: %.1f of %zu MiB", residency.usedBytes / (1024.0 * 1024.0), residency.budget >> 20
+            );
+        ImGui::Text(
+            "  streamed buffers: %u of %u resident (%.1f MiB), %u waiting", residency.resident, residency.streamable,
+            residency.residentBytes / (1024.0 * 1024.0), residency.pending
+        );
+        ImGui::Text(
+            "  loads %llu, evictions %llu, failed %llu", static_cast<unsigned long long>(residency.loads),
+            static_cast<unsigned long long>(residency.evictions), static_cast<unsigned long long>(residency.loadFailures)
+        );
+    }
+    const auto& arena = frameArena();
+    ImGui::Text(
+        "Frame arena: %.1f KiB, peak %.1f of %zu KiB, %llu overflows", arena.lastFrameUsed() / 1024.0,
+        arena.highWatermark() / 1024.0, arena.capacity() / 1024, static_cast<unsigned long long>(arena.overflows())
+    );
+    ImGui::Text(
+        "Per second: %u frames rendered, %u skipped, %.1f ms CPU",
+        activity.framesRendered, activity.framesSkipped, activity.cpuMsPerSecond
+    );
+
+    ImGui::Separator();
+    ImGui::TextDisabled("F1: toggle this window, F2: ImGui demo window");
+    ImGui::End();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "gpu_buffer_allocator.h"
+#include "residency.h"
+#include "stats.h"
+#include "time_series.h"
+#include "upload_manager.h"
+
+// ImGui window with frame statistics. Frame times and uploads are kept for the
+// whole run in time series, the detailed per-frame stats only while visible.
+// The caller should not request GPU timings while it is hidden.
+struct Dashboard {
+    public:
+    static constexpr int historySize = 240;
+    // Recorded without allocating, about 4.6 hours at 60 FPS. Reserved memory
+    // only becomes resident as it fills up.
+    static constexpr size_t reservedFrames = 1 << 20;
+
+    bool visible = true;
+    bool showDemoWindow = false;
+
+    Dashboard();
+    void record(const FrameStats& stats);
+    void record(const ActivityStats& stats) { activity = stats; }
+    void record(const GpuBufferAllocator::Stats& stats) { meshBuffers = stats; }
+    void record(const ResidencyManager::Stats& stats) { residency = stats; }
+    void record(const UploadManager::Stats& stats) { stagedUploads = stats; }
+    void draw();
+
+    private:
+    static float frameTimeAt(void* data, int index);
+    void plot(const char* label, const TimeSeries& series, const char* unit);
+    void drawGpuResources();
+    void drawImGuiMemory(double allocationsPerSecond);
+
+    TimeSeries frameTimes;
+    TimeSeries gpuTimes; // 0 for frames without GPU timings
+    TimeSeries uploads; // KiB
+    int plotSpan = historySize; // Frames shown in the plots
+
+    ActivityStats activity = {};
+    GpuBufferAllocator::Stats meshBuffers = {};
+    ResidencyManager::Stats residency = {};
+    UploadManager::Stats stagedUploads = {};
+    uint64_t renderTargetAllocations = 0;
+    FrameStats history[historySize] = {};
+    int next = 0;
+    int count = 0;
+    size_t residentBytes = 0;
+    double lastResidentUpdate = 0;
+};
@@ -0,0 +1,287 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <imgui.h>
+
+#include "font_cache.h"
+#include "logs.h"
+#include "trace.h"
+
+namespace {
+
+// File layout, all in native byte order since the cache never leaves the machine:
+//   FontCacheHeader
+//   float[4] x lineCount (TexUvLines)
+//   FontRecord + ImFontGlyph[glyphCount], for every font
+//   RGBA32 pixels
+const char FONT_CACHE_MAGIC[8] = {'I', 'M', 'F', 'O', 'N', 'T', 'S', '\0'};
+const uint32_t FONT_CACHE_VERSION = 1;
+
+struct FontCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t imguiVersion;
+    uint64_t key;
+    uint32_t glyphSize; // sizeof(ImFontGlyph), guards against layout changes
+    uint32_t fontCount;
+    uint32_t lineCount;
+    int32_t width;
+    int32_t height;
+    float uvScale[2];
+    float uvWhitePixel[2];
+    uint32_t usesColors;
+};
+
+struct FontRecord {
+    float size;
+    float ascent;
+    float descent;
+    uint32_t glyphCount;
+    uint32_t fallbackChar;
+    uint32_t ellipsisChar;
+};
+
+constexpr uint32_t lineCount = IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1;
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t cacheKey(const FontSpec* fonts, size_t fontCount) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const int version = IMGUI_VERSION_NUM;
+    hash = fnv1a(hash, &version, sizeof(version));
+    for (size_t i = 0; i < fontCount; i++) {
+        hash = fnv1a(hash, &fonts[i].size, sizeof(fonts[i].size));
+        if (!fonts[i].path) {
+            hash = fnv1a(hash, "default", 7);
+            continue;
+        }
+        hash = fnv1a(hash, fonts[i].path, std::strlen(fonts[i].path));
+        // Size and mtime instead of the contents, hashing the file would cost a read
+        struct stat info = {};
+        if (stat(fonts[i].path, &info) == 0) {
+            const int64_t stamp[2] = {static_cast<int64_t>(info.st_size), static_cast<int64_t>(info.st_mtime)};
+            hash = fnv1a(hash, stamp, sizeof(stamp));
+        }
+    }
+    return hash;
+}
+
+#if IMGUI_VERSION_NUM < 19200
+
+bool saveCache(const ImFontAtlas* atlas, uint64_t key, const unsigned char* pixels, const char* path) {
+    FontCacheHeader header = {};
+    std::memcpy(header.magic, FONT_CACHE_MAGIC, sizeof(header.magic));
+    header.version = FONT_CACHE_VERSION;
+    header.imguiVersion = IMGUI_VERSION_NUM;
+    header.key = key;
+    header.glyphSize = sizeof(ImFontGlyph);
+    header.fontCount = static_cast<uint32_t>(atlas->Fonts.Size);
+    header.lineCount = lineCount;
+    header.width = atlas->TexWidth;
+    header.height = atlas->TexHeight;
+    header.uvScale[0] = atlas->TexUvScale.x;
+    header.uvScale[1] = atlas->TexUvScale.y;
+    header.uvWhitePixel[0] = atlas->TexUvWhitePixel.x;
+    header.uvWhitePixel[1] = atlas->TexUvWhitePixel.y;
+    header.usesColors = atlas->TexPixelsUseColors;
+
+    // Written next to the target and renamed, so a crash never leaves half a cache
+    const auto temporary = std::string(path) + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        warning("Could not write font cache " << temporary);
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(atlas->TexUvLines, sizeof(ImVec4), lineCount, file) == lineCount;
+    for (const ImFont* font : atlas->Fonts) {
+        const FontRecord record = {
+            font->FontSize, font->Ascent, font->Descent, static_cast<uint32_t>(font->Glyphs.Size),
+            static_cast<uint32_t>(font->FallbackChar), static_cast<uint32_t>(font->EllipsisChar),
+        };
+        ok = ok && std::fwrite(&record, sizeof(record), 1, file) == 1;
+        const size_t glyphCount = font->Glyphs.Size;
+        ok = ok && std::fwrite(font->Glyphs.Data, sizeof(ImFontGlyph), glyphCount, file) == glyphCount;
+    }
+    const size_t pixelBytes = static_cast<size_t>(atlas->TexWidth) * atlas->TexHeight * 4;
+    ok = ok && std::fwrite(pixels, 1, pixelBytes, file) == pixelBytes;
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok || std::rename(temporary.c_str(), path) != 0) {
+        warning("Could not write font cache " << path);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Fills the atlas from the mapped cache, which must match the atlas's fonts
+bool restoreCache(ImFontAtlas* atlas, uint64_t key, const char* data, size_t size) {
+    FontCacheHeader header = {};
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, FONT_CACHE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != FONT_CACHE_VERSION
+        || header.imguiVersion != IMGUI_VERSION_NUM
+        || header.key != key
+        || header.glyphSize != sizeof(ImFontGlyph)
+        || header.fontCount != static_cast<uint32_t>(atlas->Fonts.Size)
+        || header.lineCount != lineCount
+        || header.width <= 0 || header.height <= 0)
+        return false;
+
+    // Validate every length before touching the atlas
+    size_t offset = sizeof(header) + lineCount * sizeof(ImVec4);
+    const size_t fontsOffset = offset;
+    for (uint32_t i = 0; i < header.fontCount; i++) {
+        FontRecord record = {};
+        if (offset + sizeof(record) > size)
+            return false;
+        std::memcpy(&record, data + offset, sizeof(record));
+        offset += sizeof(record) + static_cast<size_t>(record.glyphCount) * sizeof(ImFontGlyph);
+    }
+    const size_t pixelBytes = static_cast<size_t>(header.width) * header.height * 4;
+    if (offset + pixelBytes != size)
+        return false;
+
+    std::memcpy(atlas->TexUvLines, data + sizeof(header), lineCount * sizeof(ImVec4));
+    offset = fontsOffset;
+    for (int i = 0; i < atlas->Fonts.Size; i++) {
+        FontRecord record = {};
+        std::memcpy(&record, data + offset, sizeof(record));
+        offset += sizeof(record);
+
+        ImFont* font = atlas->Fonts[i];
+        font->ClearOutputData();
+        font->ContainerAtlas = atlas;
+        font->ConfigData = &atlas->ConfigData[i];
+        font->ConfigDataCount = 1;
+        font->FontSize = record.size;
+        font->Ascent = record.ascent;
+        font->Descent = record.descent;
+        font->FallbackChar = static_cast<ImWchar>(record.fallbackChar);
+        font->EllipsisChar = static_cast<ImWchar>(record.ellipsisChar);
+        font->Glyphs.resize(static_cast<int>(record.glyphCount));
+        std::memcpy(font->Glyphs.Data, data + offset, record.glyphCount * sizeof(ImFontGlyph));
+        offset += record.glyphCount * sizeof(ImFontGlyph);
+        font->BuildLookupTable();
+    }
+
+    // The atlas frees the pixels with IM_FREE, so they cannot stay in the mapping
+    auto pixels = static_cast<unsigned int*>(IM_ALLOC(pixelBytes));
+    std::memcpy(pixels, data + offset, pixelBytes);
+    atlas->ClearTexData();
+    atlas->TexPixelsRGBA32 = pixels;
+    atlas->TexWidth = header.width;
+    atlas->TexHeight = header.height;
+    atlas->TexUvScale = ImVec2(header.uvScale[0], header.uvScale[1]);
+    atlas->TexUvWhitePixel = ImVec2(header.uvWhitePixel[0], header.uvWhitePixel[1]);
+    atlas->TexPixelsUseColors = header.usesColors != 0;
+    atlas->TexReady = true;
+    return true;
+}
+
+bool loadCache(ImFontAtlas* atlas, uint64_t key, const char* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const bool loaded = restoreCache(atlas, key, static_cast<const char*>(mapping), size);
+    munmap(mapping, size);
+    return loaded;
+}
+
+#endif
+
+// Adds the fonts without rasterizing anything yet
+bool addFonts(ImFontAtlas* atlas, const FontSpec* fonts, size_t fontCount, bool withData) {
+    for (size_t i = 0; i < fontCount; i++) {
+        ImFontConfig config;
+        config.SizePixels = fonts[i].size;
+        std::snprintf(
+            config.Name, sizeof(config.Name), "%s, %.0fpx",
+            fonts[i].path ? fonts[i].path : "default", fonts[i].size
+        );
+        if (!withData) {
+            // A cached atlas never rasterizes, but AddFont insists on some font data
+            static char placeholder = 0;
+            config.FontData = &placeholder;
+            config.FontDataSize = 1;
+            config.FontDataOwnedByAtlas = false;
+            atlas->AddFont(&config);
+        } else if (!fonts[i].path) {
+            atlas->AddFontDefault(&config);
+        } else if (!atlas->AddFontFromFileTTF(fonts[i].path, fonts[i].size, &config)) {
+            error("Could not load font " << fonts[i].path);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadFontAtlas(ImFontAtlas* atlas, const FontSpec* fonts, size_t fontCount, const char* cachePath) {
+    static const TraceEvent<uint32_t, float> atlasEvent("font_atlas", {"cached", "ms"});
+    const int64_t start = Trace::now();
+    auto elapsedMs = [start] { return (Trace::now() - start) / 1e6f; };
+    const uint64_t key = cacheKey(fonts, fontCount);
+
+#if IMGUI_VERSION_NUM < 19200
+    if (addFonts(atlas, fonts, fontCount, false) && loadCache(atlas, key, cachePath)) {
+        const float ms = elapsedMs();
+        atlasEvent(1, ms);
+        info("Font atlas loaded from " << cachePath << " in " << ms << "ms");
+        return true;
+    }
+    atlas->Clear();
+#endif
+
+    if (!addFonts(atlas, fonts, fontCount, true))
+        return false;
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    // Builds the atlas, the backend would do this on its first frame otherwise
+    atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    if (!pixels) {
+        error("Could not build the font atlas");
+        return false;
+    }
+    const float ms = elapsedMs();
+    atlasEvent(0, ms);
+    info("Font atlas " << width << "x" << height << " built in " << ms << "ms");
+
+#if IMGUI_VERSION_NUM < 19200
+    saveCache(atlas, key, pixels, cachePath);
+#else
+    (void)key;
+    (void)cachePath;
+#endif
+    return true;
+}
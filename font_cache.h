@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+struct ImFontAtlas;
+
+struct FontSpec {
+    const char* path; // nullptr for ImGui's built-in font
+    float size;
+};
+
+// Adds the fonts to the atlas and fills in its texture and glyph tables,
+// either from the cache file or by building the atlas and saving the result.
+// The cache key covers the ImGui version and every font's path, size, file
+// size and modification time, a mismatch just rebuilds. Returns false when
+// the atlas could not be built at all.
+//
+// Only implemented for the pre-1.92 static atlas, newer ImGui versions
+// rasterize glyphs on demand and always build.
+bool loadFontAtlas(ImFontAtlas* atlas, const FontSpec* fonts, size_t fontCount, const char* cachePath);
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+#include "frame_arena.h"
+#include "logs.h"
+
+namespace {
+
+constexpr size_t hugePageSize = 2 << 20;
+constexpr size_t regionAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Anonymous mapping of `size` bytes. Pages are faulted in right away where
+// supported so the first frames do not pay for them.
+char* mapMemory(size_t size, bool hugePages, bool& gotHugePages) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    gotHugePages = false;
+#ifdef MAP_HUGETLB
+    if (hugePages) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            gotHugePages = true;
+            return static_cast<char*>(memory);
+        }
+    }
+#endif
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED)
+        return nullptr;
+#ifdef MADV_HUGEPAGE
+    // Only a hint, the kernel may ignore it or back the range with huge pages later
+    if (hugePages && madvise(memory, size, MADV_HUGEPAGE) == 0)
+        gotHugePages = true;
+#endif
+    return static_cast<char*>(memory);
+}
+
+FrameArena arena;
+
+} // namespace
+
+FrameArena& frameArena() {
+    return arena;
+}
+
+FrameArena::~FrameArena() {
+    destroy();
+}
+
+bool FrameArena::init(size_t capacity, bool hugePages) {
+    destroy();
+    regionCapacity = alignUp(capacity, regionAlignment);
+    mappedSize = regionCapacity * regionCount;
+    if (hugePages)
+        mappedSize = alignUp(mappedSize, hugePageSize);
+
+    memory = mapMemory(mappedSize, hugePages, usesHugePages);
+    if (!memory) {
+        error("Could not map " << mappedSize / 1024 << " KiB for the frame arena");
+        regionCapacity = 0;
+        mappedSize = 0;
+        return false;
+    }
+    if (hugePages && !usesHugePages)
+        warning("Frame arena is not backed by huge pages");
+    info(
+        "Frame arena: " << regionCount << " x " << regionCapacity / 1024 << " KiB"
+        << (usesHugePages ? " on huge pages" : "")
+    );
+    return true;
+}
+
+void FrameArena::destroy() {
+    for (int i = 0; i < regionCount; i++)
+        releaseOverflows(i);
+    if (memory)
+        munmap(memory, mappedSize);
+    memory = nullptr;
+    mappedSize = 0;
+    regionCapacity = 0;
+    offset = 0;
+    overflowBytes = 0;
+}
+
+void FrameArena::beginFrame() {
+    lastUsed = offset + overflowBytes;
+    peak = std::max(peak, lastUsed);
+    region = (region + 1) % regionCount;
+    releaseOverflows(region);
+    offset = 0;
+    overflowBytes = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    char* base = memory + region * regionCapacity;
+    const auto address = reinterpret_cast<uintptr_t>(base);
+    const size_t start = alignUp(address + offset, alignment) - address;
+    if (start + size <= regionCapacity) {
+        offset = start + size;
+        return base + start;
+    }
+
+    overflowCount++;
+    overflowBytes += size;
+    warning_throttled(
+        LogCategory::Frame,
+        "Frame arena overflow: " << size << " bytes past " << regionCapacity / 1024 << " KiB"
+    );
+    alignment = std::max(alignment, alignof(Overflow));
+    const size_t header = alignUp(sizeof(Overflow), alignment);
+    auto block = static_cast<Overflow*>(operator new(header + size, std::align_val_t(alignment)));
+    block->next = overflowBlocks[region];
+    block->alignment = alignment;
+    overflowBlocks[region] = block;
+    return reinterpret_cast<char*>(block) + header;
+}
+
+void FrameArena::releaseOverflows(int index) {
+    Overflow* block = overflowBlocks[index];
+    while (block) {
+        Overflow* next = block->next;
+        operator delete(block, std::align_val_t(block->alignment));
+        block = next;
+    }
+    overflowBlocks[index] = nullptr;
+}
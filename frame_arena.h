@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bump allocator for data that only lives for a frame: scratch arrays, staging
+// copies, lists built and consumed within the frame. Allocating is a pointer
+// increment and nothing is ever freed individually, beginFrame() rewinds a
+// whole region at once.
+//
+// There is one region per frame in flight, so data allocated in frame N stays
+// valid until frame N + regionCount begins and may be read by the following
+// frames. A region that runs full falls back to operator new, which shows up
+// in the heap counters and in overflows(); raise the capacity until it doesn't.
+//
+// Only for the main thread.
+struct FrameArena {
+    public:
+    // Same depth as the ImGuiRenderer ring
+    static constexpr int regionCount = 3;
+
+    FrameArena() = default;
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Capacity is per region. Huge pages use MAP_HUGETLB when pages are
+    // reserved and transparent huge pages otherwise, both fall back silently.
+    bool init(size_t regionCapacity, bool hugePages);
+    void destroy();
+
+    // Switches to the next region and rewinds it
+    void beginFrame();
+
+    // alignment must be a power of two. Never returns nullptr.
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    [[nodiscard]] size_t capacity() const { return regionCapacity; }
+    // Bytes used by the current frame so far and by the last completed frame
+    [[nodiscard]] size_t used() const { return offset; }
+    [[nodiscard]] size_t lastFrameUsed() const { return lastUsed; }
+    // Most bytes any completed frame asked for, including what overflowed
+    [[nodiscard]] size_t highWatermark() const { return peak; }
+    [[nodiscard]] uint64_t overflows() const { return overflowCount; }
+    [[nodiscard]] bool hugePages() const { return usesHugePages; }
+
+    private:
+    struct Overflow {
+        Overflow* next;
+        size_t alignment;
+    };
+
+    void releaseOverflows(int region);
+
+    char* memory = nullptr;
+    size_t mappedSize = 0;
+    size_t regionCapacity = 0;
+    bool usesHugePages = false;
+    int region = 0;
+    size_t offset = 0;
+    size_t overflowBytes = 0;
+    size_t lastUsed = 0;
+    size_t peak = 0;
+    uint64_t overflowCount = 0;
+    Overflow* overflowBlocks[regionCount] = {};
+};
+
+// The arena the main loop rewinds every frame
+FrameArena& frameArena();
+
+// Standard allocator on top of a FrameArena. deallocate() is a no-op, so a
+// growing container leaves its old buffers behind until the region is
+// rewound: reserve up front. Containers must not outlive their region.
+template <typename T>
+struct FrameAllocator {
+    public:
+    using value_type = T;
+
+    FrameAllocator() noexcept : arena(&frameArena()) {}
+    explicit FrameAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+    private:
+    template <typename U>
+    friend struct FrameAllocator;
+
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,122 @@
+#include "gl_debug.h"
+
+#if GL_DEBUG
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+#include "logs.h"
+
+namespace {
+
+bool debugOutputInstalled = false;
+std::mutex seenMutex;
+// Ids are only unique per source and type, which are all 16 bit enums
+std::unordered_set<uint64_t> seenIds;
+
+const char* sourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+const char* typeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        case GL_DEBUG_TYPE_MARKER: return "marker";
+        case GL_DEBUG_TYPE_PUSH_GROUP: return "push group";
+        case GL_DEBUG_TYPE_POP_GROUP: return "pop group";
+        default: return "other";
+    }
+}
+
+void APIENTRY debugCallback(
+    GLenum source, GLenum type, GLuint id, GLenum severity,
+    GLsizei length, const GLchar* message, const void*
+) {
+    // Informational messages tend to repeat for every draw, only report them once
+    if (severity == GL_DEBUG_SEVERITY_LOW || severity == GL_DEBUG_SEVERITY_NOTIFICATION) {
+        std::lock_guard lock(seenMutex);
+        const uint64_t key = static_cast<uint64_t>(source & 0xffff) << 48 | static_cast<uint64_t>(type & 0xffff) << 32 | id;
+        if (!seenIds.insert(key).second)
+            return;
+    }
+
+    auto text = std::string_view(message, length < 0 ? std::char_traits<char>::length(message) : length);
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH:
+            error_throttled(LogCategory::GL, "GL " << sourceName(source) << " " << typeName(type) << " " << id << ": " << text);
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            warning_throttled(LogCategory::GL, "GL " << sourceName(source) << " " << typeName(type) << " " << id << ": " << text);
+            break;
+        case GL_DEBUG_SEVERITY_LOW:
+            info_throttled(LogCategory::GL, "GL " << sourceName(source) << " " << typeName(type) << " " << id << ": " << text);
+            break;
+        default:
+            debug_throttled(LogCategory::GL, "GL " << sourceName(source) << " " << typeName(type) << " " << id << ": " << text);
+            break;
+    }
+}
+
+} // namespace
+
+bool installGlDebugOutput(GLenum minimumSeverity) {
+    if (!GLAD_GL_KHR_debug) {
+        warning("GL_KHR_debug is not supported, falling back to glGetError checks");
+        return false;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    // Report on the calling thread, right at the offending call
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debugCallback, nullptr);
+
+    // Severities are ordered HIGH > MEDIUM > LOW > NOTIFICATION
+    const GLenum severities[] = {
+        GL_DEBUG_SEVERITY_NOTIFICATION,
+        GL_DEBUG_SEVERITY_LOW,
+        GL_DEBUG_SEVERITY_MEDIUM,
+        GL_DEBUG_SEVERITY_HIGH,
+    };
+    bool enabled = false;
+    for (auto severity : severities) {
+        if (severity == minimumSeverity)
+            enabled = true;
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, enabled ? GL_TRUE : GL_FALSE);
+    }
+
+    debugOutputInstalled = true;
+    return true;
+}
+
+void labelGlObject(GLenum identifier, GLuint name, const char* label) {
+    if (GLAD_GL_KHR_debug)
+        glObjectLabel(identifier, name, -1, label);
+}
+
+bool checkGlError(const char* operation) {
+    // The callback reports errors already, don't add a synchronizing glGetError
+    if (debugOutputInstalled)
+        return true;
+
+    GLenum code = glGetError();
+    if (code == GL_NO_ERROR)
+        return true;
+
+    error("GL error 0x" << std::hex << code << std::dec << " after " << operation);
+    return false;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// GL error detection through KHR_debug. Enabled in debug builds, in release
+// builds everything here is an empty inline and no glGetError call remains.
+#ifndef GL_DEBUG
+#ifdef NDEBUG
+#define GL_DEBUG 0
+#else
+#define GL_DEBUG 1
+#endif
+#endif
+
+#if GL_DEBUG
+// Installs the debug message callback, messages below minimumSeverity are
+// disabled in the driver. Returns false when KHR_debug is not available.
+bool installGlDebugOutput(GLenum minimumSeverity);
+// Names an object in driver messages and debugging tools
+void labelGlObject(GLenum identifier, GLuint name, const char* label);
+// Fallback for drivers without KHR_debug, returns false if an error was pending
+bool checkGlError(const char* operation);
+#else
+inline bool installGlDebugOutput(GLenum) { return false; }
+inline void labelGlObject(GLenum, GLuint, const char*) {}
+inline bool checkGlError(const char*) { return true; }
+#endif
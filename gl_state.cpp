@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "gl_state.h"
+#include "stats.h"
+
+namespace {
+
+// Every live GlState, GL is only used from the main thread
+std::vector<GlState*> liveStates;
+
+} // namespace
+
+GlState::GlState() {
+    invalidate();
+    liveStates.push_back(this);
+}
+
+GlState::~GlState() {
+    liveStates.erase(std::find(liveStates.begin(), liveStates.end(), this));
+}
+
+void GlState::useProgram(GLuint id) {
+    if (program == id) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glUseProgram(id);
+    program = id;
+}
+
+void GlState::bindVertexArray(GLuint id) {
+    if (vertexArray == id) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glBindVertexArray(id);
+    vertexArray = id;
+}
+
+void GlState::bindBuffer(GLenum target, GLuint buffer) {
+    GLuint* cached = nullptr;
+    switch (target) {
+        case GL_ARRAY_BUFFER: cached = &arrayBuffer; break;
+        case GL_PIXEL_UNPACK_BUFFER: cached = &pixelUnpackBuffer; break;
+        case GL_COPY_READ_BUFFER: cached = &copyReadBuffer; break;
+        case GL_COPY_WRITE_BUFFER: cached = &copyWriteBuffer; break;
+        // Element array bindings are VAO state, always pass them through
+        default: glBindBuffer(target, buffer); return;
+    }
+    if (*cached == buffer) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    *cached = buffer;
+}
+
+void GlState::activeTexture(GLenum unit) {
+    if (activeUnit == unit) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glActiveTexture(unit);
+    activeUnit = unit;
+}
+
+void GlState::bindTexture(GLenum target, GLuint texture) {
+    const int unit = activeUnit == unknown ? -1 : static_cast<int>(activeUnit - GL_TEXTURE0);
+    if (target != GL_TEXTURE_2D || unit < 0 || unit >= textureUnits) {
+        glBindTexture(target, texture);
+        return;
+    }
+    if (textures[unit] == texture) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glBindTexture(target, texture);
+    textures[unit] = texture;
+}
+
+void GlState::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if ((!draw || drawFramebuffer == framebuffer) && (!read || readFramebuffer == framebuffer)) {
+        frameCounters().glCallsFiltered++;
+        return;
+    }
+    glBindFramebuffer(target, framebuffer);
+    if (draw) drawFramebuffer = framebuffer;
+    if (read) readFramebuffer = framebuffer;
+}
+
+void GlState::drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    if (instances == 1)
+        glDrawArrays(mode, first, count);
+    else
+        glDrawArraysInstanced(mode, first, count, instances);
+
+    auto& counters = frameCounters();
+    counters.drawCalls++;
+    if (mode == GL_TRIANGLES)
+        counters.triangles += static_cast<uint64_t>(count / 3) * instances;
+    else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+        counters.triangles += static_cast<uint64_t>(count - 2) * instances;
+}
+
+void GlState::drawElements(GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLint baseVertex, GLsizei instances) {
+    const auto indices = reinterpret_cast<const void*>(offset);
+    if (instances == 1)
+        glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    else
+        glDrawElementsInstancedBaseVertex(mode, count, type, indices, instances, baseVertex);
+
+    auto& counters = frameCounters();
+    counters.drawCalls++;
+    if (mode == GL_TRIANGLES)
+        counters.triangles += static_cast<uint64_t>(count / 3) * instances;
+}
+
+void GlState::bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    auto& counters = frameCounters();
+    counters.uploadCalls++;
+    if (data)
+        counters.bytesUploaded += size;
+}
+
+void GlState::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glBufferSubData(target, offset, size, data);
+    auto& counters = frameCounters();
+    counters.uploadCalls++;
+    counters.bytesUploaded += size;
+}
+
+void GlState::mapBufferWrite(GLenum target, GLintptr offset, GLsizeiptr size, const void* data, GLbitfield access) {
+    auto pointer = glMapBufferRange(target, offset, size, GL_MAP_WRITE_BIT | access);
+    if (!pointer)
+        return;
+    std::memcpy(pointer, data, size);
+    glUnmapBuffer(target);
+
+    auto& counters = frameCounters();
+    counters.uploadCalls++;
+    counters.bytesUploaded += size;
+}
+
+void GlState::invalidate() {
+    program = unknown;
+    vertexArray = unknown;
+    arrayBuffer = unknown;
+    pixelUnpackBuffer = unknown;
+    copyReadBuffer = unknown;
+    copyWriteBuffer = unknown;
+    drawFramebuffer = unknown;
+    readFramebuffer = unknown;
+    activeUnit = unknown;
+    for (auto& texture : textures)
+        texture = unknown;
+}
+
+void GlState::forget(GpuResourceType type, GLuint name) {
+    for (GlState* state : liveStates)
+        state->forgetObject(type, name);
+}
+
+void GlState::forgetObject(GpuResourceType type, GLuint name) {
+    auto clear = [name](GLuint& cached) {
+        if (cached == name)
+            cached = unknown;
+    };
+    switch (type) {
+        case GpuResourceType::Buffer:
+            clear(arrayBuffer);
+            clear(pixelUnpackBuffer);
+            clear(copyReadBuffer);
+            clear(copyWriteBuffer);
+            break;
+        case GpuResourceType::VertexArray:
+            clear(vertexArray);
+            break;
+        case GpuResourceType::Program:
+            clear(program);
+            break;
+        case GpuResourceType::Texture:
+            for (auto& texture : textures)
+                clear(texture);
+            break;
+        case GpuResourceType::Framebuffer:
+            clear(drawFramebuffer);
+            clear(readFramebuffer);
+            break;
+        case GpuResourceType::Count:
+            break;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "gpu_resources.h"
+
+// Shadow copy of the GL bindings we touch every frame. Redundant binds are
+// filtered out and draws/uploads are counted for the frame stats. Call
+// invalidate() after code that changes bindings behind our back.
+struct GlState {
+    public:
+    GlState();
+    ~GlState();
+    GlState(const GlState&) = delete;
+    GlState& operator=(const GlState&) = delete;
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count, GLsizei instances = 1);
+    // glDrawElementsBaseVertex, offset is in bytes into the VAO's element buffer
+    void drawElements(GLenum mode, GLsizei count, GLenum type, GLintptr offset, GLint baseVertex = 0, GLsizei instances = 1);
+    void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+    // glMapBufferRange + memcpy + glUnmapBuffer, access is OR-ed with GL_MAP_WRITE_BIT
+    void mapBufferWrite(GLenum target, GLintptr offset, GLsizeiptr size, const void* data, GLbitfield access);
+
+    // Forget everything, the next bind of each kind always reaches GL
+    void invalidate();
+    // Called by GpuResources when it deletes an object. GL unbinds it and may
+    // hand its name to a new object, so no GlState may still consider that
+    // name bound. Names are shared between contexts for most types, so this
+    // goes to every GlState; a container name equal by chance only costs a
+    // redundant bind.
+    static void forget(GpuResourceType type, GLuint name);
+
+    private:
+    static constexpr GLuint unknown = ~0u;
+    static constexpr int textureUnits = 8;
+
+    void forgetObject(GpuResourceType type, GLuint name);
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint arrayBuffer;
+    GLuint pixelUnpackBuffer;
+    GLuint copyReadBuffer;
+    GLuint copyWriteBuffer;
+    GLuint drawFramebuffer;
+    GLuint readFramebuffer;
+    GLenum activeUnit;
+    GLuint textures[textureUnits];
+};
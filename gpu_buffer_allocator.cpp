@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <string>
+
+#include "gpu_buffer_allocator.h"
+#include "gl_debug.h"
+#include "logs.h"
+
+namespace {
+
+constexpr uint32_t indexMask = (1u << 20) - 1;
+
+size_t alignOffset(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+GpuBufferAllocator::GpuBufferAllocator(const char* label, size_t pageSize) : label(label), pageSize(pageSize) {}
+
+void GpuBufferAllocator::destroy() {
+    pages.clear();
+    allocations.clear();
+    freeHandles.clear();
+    liveAllocations = 0;
+    usedBytes = 0;
+}
+
+size_t GpuBufferAllocator::paddedSize(size_t size, size_t alignment) {
+    // Block offsets are multiples of the granularity, other alignments need slack
+    return RangeAllocator::granularity % alignment == 0 ? size : size + alignment - 1;
+}
+
+int GpuBufferAllocator::addPage(GlState& gl, size_t size) {
+    Page page;
+    page.buffer = gpuResources().create<GpuResourceType::Buffer>();
+    if (!page.buffer)
+        return -1;
+    page.ranges = RangeAllocator(size);
+    page.buffer.setMemory(page.ranges.capacity());
+
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, page.buffer.id());
+    glBufferData(GL_COPY_WRITE_BUFFER, page.ranges.capacity(), nullptr, GL_STATIC_DRAW);
+    const auto name = std::string(label) + " " + std::to_string(pages.size());
+    labelGlObject(GL_BUFFER, page.buffer.id(), name.c_str());
+    info("Added " << name << ", " << page.ranges.capacity() / 1024 << " KiB");
+
+    pages.push_back(std::move(page));
+    return static_cast<int>(pages.size() - 1);
+}
+
+void GpuBufferAllocator::place(uint32_t handle, int pageIndex, uint32_t block) {
+    auto& page = pages[pageIndex];
+    auto& allocation = allocations[handle & indexMask];
+    allocation.page = pageIndex;
+    allocation.block = block;
+    allocation.offset = alignOffset(page.ranges.offset(block), allocation.alignment);
+    if (page.owners.size() <= block)
+        page.owners.resize(block + 1);
+    page.owners[block] = handle;
+}
+
+uint32_t GpuBufferAllocator::allocate(GlState& gl, size_t size, size_t alignment) {
+    const size_t padded = paddedSize(size, alignment);
+    int pageIndex = -1;
+    uint32_t block = RangeAllocator::invalid;
+    for (size_t i = 0; i < pages.size() && block == RangeAllocator::invalid; i++) {
+        block = pages[i].ranges.allocate(padded);
+        pageIndex = static_cast<int>(i);
+    }
+    if (block == RangeAllocator::invalid) {
+        pageIndex = addPage(gl, std::max(pageSize, padded));
+        if (pageIndex < 0)
+            return 0;
+        block = pages[pageIndex].ranges.allocate(padded);
+    }
+
+    uint32_t index = 0;
+    if (!freeHandles.empty()) {
+        index = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        index = static_cast<uint32_t>(allocations.size());
+        allocations.push_back({1, 0, 0, 0, 0, 1});
+    }
+    auto& allocation = allocations[index];
+    allocation.size = size;
+    allocation.alignment = alignment;
+    const uint32_t handle = allocation.generation << indexBits | index;
+    place(handle, pageIndex, block);
+    liveAllocations++;
+    usedBytes += size;
+    return handle;
+}
+
+const GpuBufferAllocator::Allocation* GpuBufferAllocator::find(uint32_t handle) const {
+    const uint32_t index = handle & indexMask;
+    if (handle == 0 || index >= allocations.size() || allocations[index].generation != handle >> indexBits)
+        return nullptr;
+    return &allocations[index];
+}
+
+void GpuBufferAllocator::free(uint32_t handle) {
+    const Allocation* allocation = find(handle);
+    if (!allocation) {
+        warning("Freed a stale " << label << " handle " << handle);
+        return;
+    }
+    pages[allocation->page].ranges.free(allocation->block);
+    liveAllocations--;
+    usedBytes -= allocation->size;
+
+    const uint32_t index = handle & indexMask;
+    auto& generation = allocations[index].generation;
+    generation = std::max((generation + 1) & ((1u << (32 - indexBits)) - 1), 1u);
+    freeHandles.push_back(index);
+}
+
+GpuBufferAllocator::Range GpuBufferAllocator::range(uint32_t handle) const {
+    const Allocation* allocation = find(handle);
+    if (!allocation)
+        return {0, 0, 0, -1};
+    return {pages[allocation->page].buffer.id(), allocation->offset, allocation->size, allocation->page};
+}
+
+void GpuBufferAllocator::upload(GlState& gl, uint32_t handle, const void* data, size_t size, size_t offset) {
+    const Range target = range(handle);
+    if (!target.buffer || offset + size > target.size) {
+        error("Upload of " << size << " bytes does not fit " << label << " allocation " << handle);
+        return;
+    }
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, target.buffer);
+    gl.bufferSubData(GL_COPY_WRITE_BUFFER, target.offset + offset, size, data);
+}
+
+size_t GpuBufferAllocator::compact(GlState& gl, size_t maxBytes) {
+    int worst = -1;
+    float worstFragmentation = compactThreshold;
+    for (size_t i = 0; i < pages.size(); i++) {
+        const float fragmentation = pages[i].ranges.fragmentation();
+        if (fragmentation > worstFragmentation) {
+            worst = static_cast<int>(i);
+            worstFragmentation = fragmentation;
+        }
+    }
+    if (worst < 0)
+        return 0;
+
+    // Walk down from the end of the page, moving whatever fits into a hole below it
+    auto& page = pages[worst];
+    const GLuint buffer = page.buffer.id();
+    gl.bindBuffer(GL_COPY_READ_BUFFER, buffer);
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    size_t moved = 0;
+    uint32_t block = page.ranges.previousUsed(RangeAllocator::invalid);
+    for (int candidate = 0; candidate < maxCandidates && block != RangeAllocator::invalid && moved < maxBytes; candidate++) {
+        const uint32_t previous = page.ranges.previousUsed(block);
+        const uint32_t target = page.ranges.allocateBelow(page.ranges.size(block), page.ranges.offset(block));
+        if (target != RangeAllocator::invalid) {
+            const uint32_t handle = page.owners[block];
+            const auto& allocation = allocations[handle & indexMask];
+            const size_t from = allocation.offset;
+            place(handle, worst, target);
+            // Source and destination never overlap, the target ends below the source block
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, allocation.offset, allocation.size);
+            page.ranges.free(block);
+            moved += allocation.size;
+        }
+        block = previous;
+    }
+    bytesMoved += moved;
+    return moved;
+}
+
+GpuBufferAllocator::Stats GpuBufferAllocator::stats() const {
+    Stats stats = {};
+    stats.pages = static_cast<int>(pages.size());
+    stats.allocations = liveAllocations;
+    stats.usedBytes = usedBytes;
+    stats.bytesMoved = bytesMoved;
+    for (const auto& page : pages) {
+        stats.capacity += page.ranges.capacity();
+        stats.largestFree = std::max(stats.largestFree, page.ranges.largestFree());
+        stats.fragmentation = std::max(stats.fragmentation, page.ranges.fragmentation());
+    }
+    return stats;
+}
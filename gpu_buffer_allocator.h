@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+#include "range_allocator.h"
+
+// Vertex and index data of many meshes carved out of a few large GL buffers
+// (pages), so meshes sharing a page can be drawn without rebinding, with base
+// vertex and index offsets. Ranges within a page come from a RangeAllocator,
+// a new page is added when none has room.
+//
+// compact() moves allocations from the end of the most fragmented page into
+// holes further down with glCopyBufferSubData, a few per frame. Offsets can
+// therefore change between frames: look range() up when drawing rather than
+// keeping it around. Uploads must go through GL (glBufferSubData) rather than
+// mappings, so they are ordered after draws still reading a moved range.
+struct GpuBufferAllocator {
+    public:
+    static constexpr size_t defaultPageSize = 16 << 20;
+    // Pages with less of their free space scattered are left alone
+    static constexpr float compactThreshold = 0.1f;
+
+    struct Range {
+        GLuint buffer;
+        size_t offset; // Bytes, a multiple of the allocation's alignment
+        size_t size;
+        int page;
+    };
+
+    struct Stats {
+        int pages;
+        uint32_t allocations;
+        size_t capacity;
+        size_t usedBytes; // As requested, without padding
+        size_t largestFree;
+        float fragmentation; // Of the worst page
+        uint64_t bytesMoved; // By compaction, since startup
+    };
+
+    explicit GpuBufferAllocator(const char* label, size_t pageSize = defaultPageSize);
+    GpuBufferAllocator(const GpuBufferAllocator&) = delete;
+    GpuBufferAllocator& operator=(const GpuBufferAllocator&) = delete;
+
+    // Releases all pages, outstanding handles become invalid
+    void destroy();
+
+    // Any alignment works, pass the vertex stride to be able to draw with
+    // offset / stride as base vertex. Returns 0 when no page could be created.
+    uint32_t allocate(GlState& gl, size_t size, size_t alignment);
+    void free(uint32_t handle);
+    // Buffer 0 for stale handles
+    [[nodiscard]] Range range(uint32_t handle) const;
+    // `offset` is relative to the allocation
+    void upload(GlState& gl, uint32_t handle, const void* data, size_t size, size_t offset = 0);
+
+    // Moves up to about maxBytes of data, returns how much was moved
+    size_t compact(GlState& gl, size_t maxBytes);
+
+    [[nodiscard]] Stats stats() const;
+
+    private:
+    static constexpr uint32_t indexBits = 20;
+    // Allocations tried per compact() call before giving up on the page
+    static constexpr int maxCandidates = 8;
+
+    struct Page {
+        GpuBuffer buffer;
+        RangeAllocator ranges;
+        std::vector<uint32_t> owners; // Allocation handle per block index
+    };
+
+    struct Allocation {
+        uint32_t generation;
+        int page;
+        uint32_t block;
+        size_t offset;
+        size_t size;
+        size_t alignment;
+    };
+
+    static size_t paddedSize(size_t size, size_t alignment);
+    int addPage(GlState& gl, size_t size);
+    void place(uint32_t handle, int page, uint32_t block);
+    const Allocation* find(uint32_t handle) const;
+
+    const char* label;
+    size_t pageSize;
+    std::vector<Page> pages;
+    std::vector<Allocation> allocations;
+    std::vector<uint32_t> freeHandles;
+    uint32_t liveAllocations = 0;
+    size_t usedBytes = 0;
+    uint64_t bytesMoved = 0;
+};
@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include "gpu_resources.h"
+#include "gl_state.h"
+#include "logs.h"
+
+namespace {
+
+const char* const typeNames[] = {"Buffers", "Vertex arrays", "Programs", "Textures", "Framebuffers"};
+static_assert(sizeof(typeNames) / sizeof(*typeNames) == static_cast<int>(GpuResourceType::Count));
+
+constexpr uint32_t indexMask = (1u << GpuResources::indexBits) - 1;
+
+GpuResources registry;
+
+} // namespace
+
+const char* gpuResourceTypeName(GpuResourceType type) {
+    return typeNames[static_cast<int>(type)];
+}
+
+GpuResources& gpuResources() {
+    return registry;
+}
+
+GLuint GpuResources::generate(GpuResourceType type) {
+    GLuint name = 0;
+    switch (type) {
+        case GpuResourceType::Buffer:
+            glGenBuffers(1, &name);
+            break;
+        case GpuResourceType::VertexArray:
+            glGenVertexArrays(1, &name);
+            break;
+        case GpuResourceType::Program:
+            name = glCreateProgram();
+            break;
+        case GpuResourceType::Texture:
+            glGenTextures(1, &name);
+            break;
+        case GpuResourceType::Framebuffer:
+            glGenFramebuffers(1, &name);
+            break;
+        case GpuResourceType::Count:
+            break;
+    }
+    return name;
+}
+
+void GpuResources::deleteObject(GpuResourceType type, GLuint name) {
+    switch (type) {
+        case GpuResourceType::Buffer:
+            glDeleteBuffers(1, &name);
+            break;
+        case GpuResourceType::VertexArray:
+            glDeleteVertexArrays(1, &name);
+            break;
+        case GpuResourceType::Program:
+            glDeleteProgram(name);
+            break;
+        case GpuResourceType::Texture:
+            glDeleteTextures(1, &name);
+            break;
+        case GpuResourceType::Framebuffer:
+            glDeleteFramebuffers(1, &name);
+            break;
+        case GpuResourceType::Count:
+            break;
+    }
+    // The name may come back from the next glGen*, bound as far as any cache knows
+    GlState::forget(type, name);
+}
+
+uint32_t GpuResources::add(GpuResourceType type, GLuint name) {
+    if (name == 0) {
+        error("Could not create " << gpuResourceTypeName(type));
+        return 0;
+    }
+
+    auto& table = tables[static_cast<int>(type)];
+    uint32_t slot = 0;
+    if (!table.freeSlots.empty()) {
+        slot = table.freeSlots.back();
+        table.freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(table.slots.size());
+        if (slot > indexMask) {
+            error("Out of " << gpuResourceTypeName(type) << " handles");
+            deleteObject(type, name);
+            return 0;
+        }
+        // Generation 0 never appears in a handle, so handle 0 is always invalid
+        table.slots.push_back({1, 0});
+    }
+
+    table.slots[slot].entry = static_cast<uint32_t>(table.entries.size());
+    table.entries.push_back({name, slot, 0});
+    table.stats.count++;
+    return table.slots[slot].generation << indexBits | slot;
+}
+
+GpuResources::Entry* GpuResources::find(GpuResourceType type, uint32_t handle) {
+    return const_cast<Entry*>(static_cast<const GpuResources*>(this)->find(type, handle));
+}
+
+const GpuResources::Entry* GpuResources::find(GpuResourceType type, uint32_t handle) const {
+    const auto& table = tables[static_cast<int>(type)];
+    const uint32_t slot = handle & indexMask;
+    if (handle == 0 || slot >= table.slots.size() || table.slots[slot].generation != handle >> indexBits)
+        return nullptr;
+    return &table.entries[table.slots[slot].entry];
+}
+
+GLuint GpuResources::name(GpuResourceType type, uint32_t handle) const {
+    const Entry* entry = find(type, handle);
+    return entry ? entry->name : 0;
+}
+
+void GpuResources::setMemory(GpuResourceType type, uint32_t handle, size_t bytes) {
+    Entry* entry = find(type, handle);
+    if (!entry)
+        return;
+    auto& stats = tables[static_cast<int>(type)].stats;
+    stats.bytes = stats.bytes - entry->bytes + bytes;
+    entry->bytes = bytes;
+}
+
+void GpuResources::release(GpuResourceType type, uint32_t handle) {
+    Entry* entry = find(type, handle);
+    if (!entry) {
+        warning("Released a stale " << gpuResourceTypeName(type) << " handle " << handle);
+        return;
+    }
+
+    auto& table = tables[static_cast<int>(type)];
+    if (!closed) {
+        retired.push_back({type, entry->name, frame});
+        table.stats.pending++;
+    }
+    table.stats.count--;
+    table.stats.bytes -= entry->bytes;
+
+    // Keep the array dense by moving the last entry into the hole
+    const uint32_t slot = handle & indexMask;
+    const uint32_t position = table.slots[slot].entry;
+    table.entries[position] = table.entries.back();
+    table.slots[table.entries[position].slot].entry = position;
+    table.entries.pop_back();
+
+    auto& generation = table.slots[slot].generation;
+    generation = std::max((generation + 1) & generationMask, 1u);
+    table.freeSlots.push_back(slot);
+}
+
+void GpuResources::beginFrame(uint32_t newFrame) {
+    frame = newFrame;
+    // Retired in release order, so whatever is due sits at the front
+    size_t due = 0;
+    while (due < retired.size() && retired[due].frame + framesInFlight <= frame) {
+        deleteObject(retired[due].type, retired[due].name);
+        tables[static_cast<int>(retired[due].type)].stats.pending--;
+        due++;
+    }
+    retired.erase(retired.begin(), retired.begin() + due);
+}
+
+void GpuResources::shutdown() {
+    for (const auto& object : retired) {
+        deleteObject(object.type, object.name);
+        tables[static_cast<int>(object.type)].stats.pending--;
+    }
+    retired.clear();
+    for (int i = 0; i < typeCount; i++) {
+        if (tables[i].stats.count > 0)
+            debug(tables[i].stats.count << " " << typeNames[i] << " still alive at shutdown");
+    }
+    closed = true;
+}
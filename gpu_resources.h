@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+enum class GpuResourceType : uint8_t {
+    Buffer,
+    VertexArray,
+    Program,
+    Texture,
+    Framebuffer,
+    Count,
+};
+
+const char* gpuResourceTypeName(GpuResourceType type);
+
+template <GpuResourceType Type>
+struct GpuResource;
+
+// Owner of the main context's GL objects. Every type has a dense array of live
+// objects plus a slot table that maps 32 bit handles to array positions, so
+// looking up or iterating objects stays cache friendly however many there are.
+// Handles carry the slot's generation, a handle to a released object no longer
+// resolves even after its slot was reused.
+//
+// Released objects are deleted framesInFlight frames later, once no queued
+// frame can still use them; until then their names are not handed out again.
+//
+// Container objects (VAOs, framebuffers) belong to the context that created
+// them, only register those made with the main context current.
+struct GpuResources {
+    public:
+    static constexpr int framesInFlight = 3;
+    static constexpr uint32_t indexBits = 20; // About a million objects per type
+    static constexpr uint32_t generationMask = (1u << (32 - indexBits)) - 1;
+
+    struct TypeStats {
+        uint32_t count;
+        uint32_t pending; // Released, waiting for deletion
+        size_t bytes; // As reported through setMemory()
+    };
+
+    GpuResources() = default;
+    GpuResources(const GpuResources&) = delete;
+    GpuResources& operator=(const GpuResources&) = delete;
+
+    template <GpuResourceType Type>
+    GpuResource<Type> create();
+
+    // 0 for handles of released objects
+    [[nodiscard]] GLuint name(GpuResourceType type, uint32_t handle) const;
+    void setMemory(GpuResourceType type, uint32_t handle, size_t bytes);
+    void release(GpuResourceType type, uint32_t handle);
+
+    // Deletes objects released at least framesInFlight frames ago
+    void beginFrame(uint32_t frame);
+    // Deletes everything released so far, objects released afterwards are only
+    // forgotten. Call before the context goes away.
+    void shutdown();
+
+    [[nodiscard]] const TypeStats& stats(GpuResourceType type) const {
+        return tables[static_cast<int>(type)].stats;
+    }
+
+    private:
+    static constexpr int typeCount = static_cast<int>(GpuResourceType::Count);
+
+    struct Entry {
+        GLuint name;
+        uint32_t slot;
+        size_t bytes;
+    };
+
+    struct Slot {
+        uint32_t generation;
+        uint32_t entry;
+    };
+
+    struct Table {
+        std::vector<Entry> entries; // Dense, in no particular order
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        TypeStats stats = {};
+    };
+
+    struct Retired {
+        GpuResourceType type;
+        GLuint name;
+        uint32_t frame;
+    };
+
+    static GLuint generate(GpuResourceType type);
+    static void deleteObject(GpuResourceType type, GLuint name);
+    uint32_t add(GpuResourceType type, GLuint name);
+    // Entry of a live handle, nullptr otherwise
+    Entry* find(GpuResourceType type, uint32_t handle);
+    [[nodiscard]] const Entry* find(GpuResourceType type, uint32_t handle) const;
+
+    Table tables[typeCount];
+    std::vector<Retired> retired;
+    uint32_t frame = 0;
+    bool closed = false;
+};
+
+// The registry of the main context
+GpuResources& gpuResources();
+
+// Move-only owner of one registered object, released when it goes away
+template <GpuResourceType Type>
+struct GpuResource {
+    public:
+    GpuResource() = default;
+    explicit GpuResource(uint32_t handle) : handle(handle) {}
+    ~GpuResource() { reset(); }
+    GpuResource(const GpuResource&) = delete;
+    GpuResource& operator=(const GpuResource&) = delete;
+    GpuResource(GpuResource&& other) noexcept : handle(std::exchange(other.handle, 0)) {}
+    GpuResource& operator=(GpuResource&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = std::exchange(other.handle, 0);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] GLuint id() const { return handle ? gpuResources().name(Type, handle) : 0; }
+    [[nodiscard]] uint32_t getHandle() const { return handle; }
+    explicit operator bool() const { return handle != 0; }
+
+    void setMemory(size_t bytes) { gpuResources().setMemory(Type, handle, bytes); }
+    void reset() {
+        if (handle)
+            gpuResources().release(Type, handle);
+        handle = 0;
+    }
+
+    private:
+    uint32_t handle = 0;
+};
+
+using GpuBuffer = GpuResource<GpuResourceType::Buffer>;
+using GpuVertexArray = GpuResource<GpuResourceType::VertexArray>;
+using GpuProgram = GpuResource<GpuResourceType::Program>;
+using GpuTexture = GpuResource<GpuResourceType::Texture>;
+using GpuFramebuffer = GpuResource<GpuResourceType::Framebuffer>;
+
+template <GpuResourceType Type>
+GpuResource<Type> GpuResources::create() {
+    return GpuResource<Type>(add(Type, generate(Type)));
+}
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <imgui.h>
+#include <imgui_impl_opengl3.h>
+
+#include "imgui_renderer.h"
+#include "gl_debug.h"
+#include "logs.h"
+#include "stats.h"
+
+namespace {
+
+// Enough for the dashboard and tuning panel without growing
+constexpr size_t initialRegionSize = 512 << 10;
+constexpr GLuint64 fenceTimeout = 1000000000; // 1s in nanoseconds
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+ImGuiRenderer::~ImGuiRenderer() {
+    destroy();
+}
+
+bool ImGuiRenderer::init(GlState& gl, const char* vertexSource, const char* fragmentSource) {
+    if (!program.registerShader(vertexSource, Program::ShaderType::Vertex))
+        return false;
+    if (!program.registerShader(fragmentSource, Program::ShaderType::Fragment))
+        return false;
+    if (!program.registerProgram())
+        return false;
+    labelGlObject(GL_PROGRAM, program.getId(), "imgui program");
+    projectionLocation = glGetUniformLocation(program.getId(), "projection");
+
+    vertexArray = gpuResources().create<GpuResourceType::VertexArray>();
+    gl.bindVertexArray(vertexArray.id());
+    labelGlObject(GL_VERTEX_ARRAY, vertexArray.id(), "imgui");
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    persistent = GLAD_GL_ARB_buffer_storage;
+    createBuffer(gl, initialRegionSize);
+    info("ImGui renderer: " << (persistent ? "persistent mapped" : "unsynchronized mapped") << " ring");
+    return buffer.id() != 0;
+}
+
+void ImGuiRenderer::destroy() {
+    destroyBuffer();
+    vertexArray.reset();
+    program.destroy();
+}
+
+void ImGuiRenderer::createBuffer(GlState& gl, size_t size) {
+    destroyBuffer();
+    regionSize = size;
+    region = 0;
+    const size_t total = regionSize * framesInFlight;
+
+    buffer = gpuResources().create<GpuResourceType::Buffer>();
+    buffer.setMemory(total);
+    gl.bindVertexArray(vertexArray.id());
+    gl.bindBuffer(GL_ARRAY_BUFFER, buffer.id());
+    gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.id());
+    labelGlObject(GL_BUFFER, buffer.id(), "imgui ring");
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, total, nullptr, flags);
+        mapping = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+        if (!mapping) {
+            warning("Could not map the ImGui ring persistently, falling back to mapping per frame");
+            persistent = false;
+            createBuffer(gl, size);
+            return;
+        }
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+    }
+
+    auto attribute = [](GLuint index, GLint count, GLenum type, GLboolean normalized, size_t offset) {
+        glVertexAttribPointer(index, count, type, normalized, sizeof(ImDrawVert), reinterpret_cast<const void*>(offset));
+    };
+    attribute(0, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, pos));
+    attribute(1, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, uv));
+    attribute(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(ImDrawVert, col));
+}
+
+void ImGuiRenderer::destroyBuffer() {
+    for (auto& fence : fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (mapping) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.id());
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        mapping = nullptr;
+    }
+    // Deleted once queued frames are done with it
+    buffer.reset();
+}
+
+void ImGuiRenderer::setupRenderState(GlState& gl, const ImDrawData* drawData, int width, int height) {
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_SCISSOR_TEST);
+    glViewport(0, 0, width, height);
+
+    const float left = drawData->DisplayPos.x;
+    const float right = drawData->DisplayPos.x + drawData->DisplaySize.x;
+    const float top = drawData->DisplayPos.y;
+    const float bottom = drawData->DisplayPos.y + drawData->DisplaySize.y;
+    const float projection[4][4] = {
+        {2.0f / (right - left), 0, 0, 0},
+        {0, 2.0f / (top - bottom), 0, 0},
+        {0, 0, -1, 0},
+        {(right + left) / (left - right), (top + bottom) / (bottom - top), 0, 1},
+    };
+    gl.useProgram(program.getId());
+    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projection[0][0]);
+    gl.bindVertexArray(vertexArray.id());
+    gl.activeTexture(GL_TEXTURE0);
+}
+
+void ImGuiRenderer::render(GlState& gl, ImDrawData* drawData) {
+#if IMGUI_VERSION_NUM >= 19200
+    // Texture creation and updates are left to the stock backend
+    if (drawData->Textures)
+        for (ImTextureData* texture : *drawData->Textures)
+            if (texture->Status != ImTextureStatus_OK)
+                ImGui_ImplOpenGL3_UpdateTexture(texture);
+#endif
+
+    const int width = static_cast<int>(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+    const int height = static_cast<int>(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+    if (width <= 0 || height <= 0 || drawData->TotalVtxCount == 0)
+        return;
+
+    // Vertices first, the region start is rounded up so base vertices are whole
+    const size_t vertexBytes = drawData->TotalVtxCount * sizeof(ImDrawVert);
+    const size_t indexBytes = drawData->TotalIdxCount * sizeof(ImDrawIdx);
+    const size_t needed = vertexBytes + indexBytes + sizeof(ImDrawVert);
+    if (needed > regionSize) {
+        const size_t size = std::max(regionSize * 2, alignUp(needed * 3 / 2, 4096));
+        info("Growing the ImGui ring to " << framesInFlight << " x " << size / 1024 << " KiB");
+        createBuffer(gl, size);
+    }
+
+    region = (region + 1) % framesInFlight;
+    if (fences[region]) {
+        const GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+            warning_throttled(LogCategory::GL, "ImGui ring region " << region << " is still in use by the GPU");
+        glDeleteSync(fences[region]);
+        fences[region] = nullptr;
+    }
+
+    const size_t regionStart = region * regionSize;
+    const size_t vertexStart = alignUp(regionStart, sizeof(ImDrawVert));
+    const size_t indexStart = vertexStart + vertexBytes;
+
+    char* destination = nullptr;
+    if (persistent) {
+        destination = mapping + vertexStart;
+    } else {
+        gl.bindBuffer(GL_ARRAY_BUFFER, buffer.id());
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        destination = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, vertexStart, vertexBytes + indexBytes, access));
+        if (!destination) {
+            error("Could not map the ImGui ring");
+            return;
+        }
+    }
+
+    char* vertices = destination;
+    char* indices = destination + vertexBytes;
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+        const ImDrawList* list = drawData->CmdLists[i];
+        const size_t listVertexBytes = list->VtxBuffer.Size * sizeof(ImDrawVert);
+        const size_t listIndexBytes = list->IdxBuffer.Size * sizeof(ImDrawIdx);
+        std::memcpy(vertices, list->VtxBuffer.Data, listVertexBytes);
+        std::memcpy(indices, list->IdxBuffer.Data, listIndexBytes);
+        vertices += listVertexBytes;
+        indices += listIndexBytes;
+    }
+
+    if (!persistent)
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    auto& counters = frameCounters();
+    counters.uploadCalls++;
+    counters.bytesUploaded += vertexBytes + indexBytes;
+
+    setupRenderState(gl, drawData, width, height);
+
+    const GLenum indexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const ImVec2 clipOffset = drawData->DisplayPos;
+    const ImVec2 clipScale = drawData->FramebufferScale;
+    GLint baseVertex = static_cast<GLint>(vertexStart / sizeof(ImDrawVert));
+    size_t indexOffset = indexStart;
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+        const ImDrawList* list = drawData->CmdLists[i];
+        for (const ImDrawCmd& command : list->CmdBuffer) {
+            if (command.UserCallback) {
+                if (command.UserCallback == ImDrawCallback_ResetRenderState) {
+                    setupRenderState(gl, drawData, width, height);
+                } else {
+                    command.UserCallback(list, &command);
+                    // Callbacks may bind anything
+                    gl.invalidate();
+                }
+                continue;
+            }
+
+            const float clipMinX = (command.ClipRect.x - clipOffset.x) * clipScale.x;
+            const float clipMinY = (command.ClipRect.y - clipOffset.y) * clipScale.y;
+            const float clipMaxX = (command.ClipRect.z - clipOffset.x) * clipScale.x;
+            const float clipMaxY = (command.ClipRect.w - clipOffset.y) * clipScale.y;
+            if (clipMaxX <= clipMinX || clipMaxY <= clipMinY)
+                continue;
+            // GL scissor origin is the bottom left corner
+            glScissor(
+                static_cast<GLint>(clipMinX), static_cast<GLint>(height - clipMaxY),
+                static_cast<GLsizei>(clipMaxX - clipMinX), static_cast<GLsizei>(clipMaxY - clipMinY)
+            );
+
+            // ImTextureID is a pointer or a 64 bit integer depending on the ImGui version
+            gl.bindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)command.GetTexID());
+            gl.drawElements(
+                GL_TRIANGLES, static_cast<GLsizei>(command.ElemCount), indexType,
+                indexOffset + command.IdxOffset * sizeof(ImDrawIdx),
+                baseVertex + static_cast<GLint>(command.VtxOffset)
+            );
+        }
+        baseVertex += list->VtxBuffer.Size;
+        indexOffset += list->IdxBuffer.Size * sizeof(ImDrawIdx);
+    }
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+#include "program.h"
+
+struct ImDrawData;
+
+// Replacement for ImGui_ImplOpenGL3_RenderDrawData. All draw lists of a frame
+// are copied into one region of a ring buffer and drawn with base vertex
+// offsets, so there is a single upload per frame instead of two glBufferData
+// calls per draw list. Bindings go through GlState and nothing is queried
+// from or restored to GL, the caller's blend and scissor state is assumed off.
+//
+// The ring is persistently mapped when GL_ARB_buffer_storage is available,
+// otherwise each region is mapped unsynchronized. Fences keep the CPU from
+// overwriting a region the GPU has not consumed yet.
+//
+// Textures (the font atlas) are still created by the stock backend, so
+// ImGui_ImplOpenGL3_Init/NewFrame have to keep running.
+struct ImGuiRenderer {
+    public:
+    // Ring regions, one per frame the GPU may still be reading from
+    static constexpr int framesInFlight = 3;
+
+    ImGuiRenderer() = default;
+    ~ImGuiRenderer();
+    ImGuiRenderer(const ImGuiRenderer&) = delete;
+    ImGuiRenderer& operator=(const ImGuiRenderer&) = delete;
+
+    bool init(GlState& gl, const char* vertexSource, const char* fragmentSource);
+    // Must run while the GL context is still alive
+    void destroy();
+
+    void render(GlState& gl, ImDrawData* drawData);
+
+    [[nodiscard]] bool isPersistent() const { return persistent; }
+    [[nodiscard]] size_t getRegionSize() const { return regionSize; }
+
+    private:
+    void createBuffer(GlState& gl, size_t size);
+    void destroyBuffer();
+    void setupRenderState(GlState& gl, const ImDrawData* drawData, int width, int height);
+
+    Program program;
+    GLint projectionLocation = -1;
+    GpuVertexArray vertexArray;
+    GpuBuffer buffer;
+    char* mapping = nullptr; // Whole buffer, only when persistent
+    bool persistent = false;
+    size_t regionSize = 0;
+    int region = 0;
+    GLsync fences[framesInFlight] = {};
+};
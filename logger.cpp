@@ -0,0 +1,619 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+
+namespace {
+
+constexpr size_t ringCapacity = 1 << 18;
+constexpr size_t recordAlignment = 16;
+constexpr auto drainInterval = std::chrono::milliseconds(10);
+// How long suppressed or repeated messages may go unreported
+constexpr auto reportInterval = std::chrono::seconds(1);
+
+const char* const levelPrefixes[] = {"DEBUG: ", "INFO: ", "WARN: ", "ERRO: "};
+
+struct RecordHeader {
+    uint32_t size; // Payload bytes, or bytes to skip for padding records
+    uint8_t level;
+    uint8_t padding; // Set when the record only fills the end of the ring
+    LogSite* site;
+};
+static_assert(sizeof(RecordHeader) <= recordAlignment);
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Single-producer single-consumer ring of variable-sized records. The owning
+// thread only ever advances head, the logger thread only ever advances tail.
+struct LogRing {
+    alignas(64) std::atomic<size_t> head = 0;
+    alignas(64) std::atomic<size_t> tail = 0;
+    std::atomic<bool> orphaned = false;
+    alignas(recordAlignment) char data[ringCapacity];
+
+    bool tryPush(LogLevel level, LogSite* site, const char* message, size_t size) {
+        const size_t total = alignUp(sizeof(RecordHeader) + size, recordAlignment);
+        size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+
+        size_t offset = h % ringCapacity;
+        const size_t untilEnd = ringCapacity - offset;
+        const size_t needed = total <= untilEnd ? total : untilEnd + total;
+        if (needed > ringCapacity - (h - t))
+            return false;
+
+        // Records are never split, skip the tail end of the ring instead
+        if (total > untilEnd) {
+            RecordHeader padding = {static_cast<uint32_t>(untilEnd), 0, 1, nullptr};
+            std::memcpy(data + offset, &padding, sizeof(padding));
+            h += untilEnd;
+            offset = 0;
+        }
+
+        RecordHeader header = {static_cast<uint32_t>(size), static_cast<uint8_t>(level), 0, site};
+        std::memcpy(data + offset, &header, sizeof(header));
+        std::memcpy(data + offset + sizeof(header), message, size);
+        head.store(h + total, std::memory_order_release);
+        return true;
+    }
+
+    template<typename Sink>
+    void drain(Sink&& sink) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        const size_t h = head.load(std::memory_order_acquire);
+        while (t != h) {
+            const size_t offset = t % ringCapacity;
+            RecordHeader header = {};
+            std::memcpy(&header, data + offset, sizeof(header));
+            if (header.padding) {
+                t += header.size;
+                continue;
+            }
+            sink(static_cast<LogLevel>(header.level), header.site, data + offset + sizeof(header), header.size);
+            t += alignUp(sizeof(header) + header.size, recordAlignment);
+        }
+        tail.store(t, std::memory_order_release);
+    }
+};
+
+struct FixedStreamBuf : std::streambuf {
+    char buffer[Logger::maxMessageSize];
+
+    FixedStreamBuf() { reset(); }
+    void reset() { setp(buffer, buffer + sizeof(buffer)); }
+    [[nodiscard]] const char* data() const { return pbase(); }
+    [[nodiscard]] size_t size() const { return pptr() - pbase(); }
+};
+
+// Appends to a string owned by the caller
+struct StringStreamBuf : std::streambuf {
+    std::string* target = nullptr;
+
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof())
+            target->push_back(static_cast<char>(c));
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        target->append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+
+// What a Format tag carries
+struct FormatState {
+    std::ios_base::fmtflags flags;
+    std::streamsize precision;
+    std::streamsize width;
+    char fill;
+
+    static FormatState of(const std::ostream& stream) {
+        return {stream.flags(), stream.precision(), stream.width(), stream.fill()};
+    }
+    void apply(std::ostream& stream) const {
+        stream.flags(flags);
+        stream.precision(precision);
+        stream.width(width);
+        stream.fill(fill);
+    }
+    bool operator!=(const FormatState& other) const {
+        return flags != other.flags || precision != other.precision || width != other.width || fill != other.fill;
+    }
+};
+
+struct ThreadLog {
+    LogRecord record;
+    // Formats fallback values on the calling thread. Its state follows the
+    // record's manipulators, `emitted` is the state the logger thread will
+    // have at the end of the record so far.
+    FixedStreamBuf fallbackBuffer;
+    std::ostream fallback;
+    FormatState defaults;
+    FormatState emitted;
+    bool fallbackUsed = false;
+    LogRing* ring = nullptr;
+
+    ThreadLog() : fallback(&fallbackBuffer), defaults(FormatState::of(fallback)), emitted(defaults) {}
+    ~ThreadLog() {
+        // The logger thread frees the ring once it has been drained
+        if (ring)
+            ring->orphaned.store(true, std::memory_order_release);
+    }
+};
+
+thread_local ThreadLog threadLog;
+
+template<typename Duration>
+constexpr int64_t nanosecondsIn(Duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+int64_t nowNanoseconds() {
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    return duration_cast<nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+enum class Phase { Unstarted, Running, Stopped };
+std::atomic<Phase> phase = Phase::Unstarted;
+
+void writeDirect(LogLevel level, const char* record, size_t size) {
+    std::string message;
+    LogRecord::format(record, size, message);
+    auto stream = level == LogLevel::Error ? stderr : stdout;
+    std::fputs(levelPrefixes[static_cast<int>(level)], stream);
+    std::fwrite(message.data(), 1, message.size(), stream);
+    std::fputc('\n', stream);
+    std::fflush(stream);
+}
+
+struct LoggerState {
+    std::mutex mutex; // Guards everything below except the output buffers
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::vector<LogRing*> rings;
+    std::vector<LogSite*> sites;
+    LogThrottle throttles[static_cast<int>(LogCategory::Count)] = {
+        {10.0f, 20}, // General
+        {1.0f, 3},   // Frame
+        {10.0f, 20}, // GL
+    };
+    int64_t lastRefill = nowNanoseconds();
+    uint64_t flushRequested = 0;
+    uint64_t flushCompleted = 0;
+    bool urgent = false;
+    bool stopping = false;
+
+    std::atomic<uint64_t> dropped = 0;
+    std::string out;
+    std::string err;
+    std::thread thread;
+
+    // Owned by the logger thread
+    std::string message; // Formatted record being written
+    // Identical consecutive messages are coalesced, owned by the logger thread
+    std::string lastMessage;
+    LogLevel lastLevel = LogLevel::Debug;
+    uint32_t repeats = 0;
+    int64_t lastMessageTime = 0;
+
+    LoggerState() {
+        out.reserve(ringCapacity);
+        err.reserve(ringCapacity);
+        message.reserve(Logger::maxMessageSize);
+        lastMessage.reserve(Logger::maxMessageSize);
+        phase.store(Phase::Running, std::memory_order_release);
+        thread = std::thread([this] { run(); });
+    }
+
+    ~LoggerState() {
+        phase.store(Phase::Stopped, std::memory_order_release);
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+
+        // Rings of threads that are still alive are leaked on purpose, their
+        // thread-local destructors may still run after this point
+        for (auto ring : rings) {
+            if (ring->orphaned.load(std::memory_order_acquire))
+                delete ring;
+        }
+    }
+
+    LogRing* registerRing() {
+        std::lock_guard lock(mutex);
+        auto ring = new LogRing();
+        rings.push_back(ring);
+        return ring;
+    }
+
+    void registerSite(LogSite* site) {
+        std::lock_guard lock(mutex);
+        if (site->registered.load(std::memory_order_relaxed))
+            return;
+        sites.push_back(site);
+        site->lastReport = nowNanoseconds();
+        site->registered.store(true, std::memory_order_relaxed);
+    }
+
+    void notifyUrgent() {
+        {
+            std::lock_guard lock(mutex);
+            urgent = true;
+        }
+        wake.notify_one();
+    }
+
+    std::string& target(LogLevel level) {
+        return level == LogLevel::Error ? err : out;
+    }
+
+    void writeRepeats() {
+        if (repeats == 0)
+            return;
+        auto& buffer = target(lastLevel);
+        buffer.append(levelPrefixes[static_cast<int>(lastLevel)]);
+        buffer.append("Last message repeated ");
+        buffer.append(std::to_string(repeats));
+        buffer.append(" times\n");
+        repeats = 0;
+    }
+
+    void writeRecord(LogLevel level, LogSite* site, const char* message, size_t size, int64_t now) {
+        if (repeats < UINT32_MAX && level == lastLevel && lastMessage.compare(0, std::string::npos, message, size) == 0) {
+            repeats++;
+            return;
+        }
+        writeRepeats();
+        lastMessage.assign(message, size);
+        lastLevel = level;
+        lastMessageTime = now;
+
+        auto& buffer = target(level);
+        buffer.append(levelPrefixes[static_cast<int>(level)]);
+        buffer.append(message, size);
+        if (site && site->suppressed > 0) {
+            buffer.append(" (");
+            buffer.append(std::to_string(site->suppressed));
+            buffer.append(" similar messages suppressed)");
+            site->suppressed = 0;
+            site->lastReport = now;
+        }
+        buffer.push_back('\n');
+    }
+
+    // Must be called with the mutex held
+    void drainRings(int64_t now) {
+        for (size_t i = 0; i < rings.size();) {
+            auto ring = rings[i];
+            const bool orphaned = ring->orphaned.load(std::memory_order_acquire);
+            ring->drain([this, now](LogLevel level, LogSite* site, const char* record, size_t size) {
+                message.clear();
+                LogRecord::format(record, size, message);
+                writeRecord(level, site, message.data(), message.size(), now);
+            });
+
+            if (orphaned) {
+                delete ring;
+                rings[i] = rings.back();
+                rings.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // Must be called with the mutex held
+    void refillSites(int64_t now) {
+        const float elapsed = (now - lastRefill) / 1e9f;
+        lastRefill = now;
+
+        for (auto site : sites) {
+            const auto& throttle = throttles[static_cast<int>(site->category)];
+            site->credit += throttle.ratePerSecond * elapsed;
+            const int32_t refill = static_cast<int32_t>(site->credit);
+            site->credit -= refill;
+
+            int32_t current = site->tokens.load(std::memory_order_relaxed);
+            int32_t next = {};
+            do {
+                next = std::min(std::max(current, 0) + refill, throttle.burst);
+            } while (!site->tokens.compare_exchange_weak(current, next, std::memory_order_relaxed));
+            if (current < 0)
+                site->suppressed += -current;
+
+            // The site went quiet while suppressed, report it on its own
+            if (site->suppressed > 0 && now - site->lastReport >= nanosecondsIn(reportInterval)) {
+                auto& buffer = target(site->level);
+                buffer.append(levelPrefixes[static_cast<int>(site->level)]);
+                buffer.append(std::to_string(site->suppressed));
+                buffer.append(" messages suppressed from ");
+                const char* basename = std::strrchr(site->file, '/');
+                buffer.append(basename ? basename + 1 : site->file);
+                buffer.push_back(':');
+                buffer.append(std::to_string(site->line));
+                buffer.push_back('\n');
+                site->suppressed = 0;
+                site->lastReport = now;
+            }
+        }
+
+        if (repeats > 0 && now - lastMessageTime >= nanosecondsIn(reportInterval)) {
+            writeRepeats();
+            lastMessageTime = now;
+        }
+    }
+
+    void writeBuffers() {
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            out.clear();
+        }
+        if (!err.empty()) {
+            std::fwrite(err.data(), 1, err.size(), stderr);
+            std::fflush(stderr);
+            err.clear();
+        }
+    }
+
+    void run() {
+        std::unique_lock lock(mutex);
+        while (true) {
+            wake.wait_for(lock, drainInterval, [this] {
+                return urgent || stopping || flushRequested != flushCompleted;
+            });
+            urgent = false;
+            const bool stop = stopping;
+            const uint64_t flushTarget = flushRequested;
+
+            const int64_t now = nowNanoseconds();
+            drainRings(now);
+            refillSites(now);
+            if (stop)
+                writeRepeats();
+            lock.unlock();
+            writeBuffers();
+            lock.lock();
+
+            if (flushCompleted != flushTarget) {
+                flushCompleted = flushTarget;
+                flushed.notify_all();
+            }
+            if (stop)
+                break;
+        }
+    }
+};
+
+LoggerState& state() {
+    static LoggerState instance;
+    return instance;
+}
+
+} // namespace
+
+void LogRecord::putString(std::string_view text) {
+    const uint32_t room = static_cast<uint32_t>(capacity - std::min(capacity, size + 1 + sizeof(uint32_t)));
+    const auto length = static_cast<uint32_t>(std::min<size_t>(text.size(), room));
+    if (size + 1 + sizeof(length) > capacity)
+        return;
+    bytes[size] = static_cast<char>(Tag::String);
+    std::memcpy(bytes + size + 1, &length, sizeof(length));
+    std::memcpy(bytes + size + 1 + sizeof(length), text.data(), length);
+    size += 1 + sizeof(length) + length;
+    consumeWidth();
+}
+
+void LogRecord::syncFormat() {
+    auto& log = threadLog;
+    const FormatState current = FormatState::of(log.fallback);
+    if (current != log.emitted) {
+        put(Tag::Format, &current, sizeof(current));
+        log.emitted = current;
+    }
+}
+
+void LogRecord::resetFallbackWidth() {
+    auto& log = threadLog;
+    log.fallback.width(0);
+    log.emitted.width = 0;
+    fallbackWidth = 0;
+}
+
+std::ostream& LogRecord::beginFallback() {
+    auto& log = threadLog;
+    log.fallbackUsed = true;
+    log.fallbackBuffer.reset();
+    // Values formatted here are padded already, the logger thread must not pad them again
+    if (log.emitted.width != 0) {
+        FormatState unpadded = log.emitted;
+        unpadded.width = 0;
+        put(Tag::Format, &unpadded, sizeof(unpadded));
+        log.emitted = unpadded;
+    }
+    return log.fallback;
+}
+
+void LogRecord::endFallback() {
+    auto& log = threadLog;
+    const std::streamsize width = log.fallback.width();
+    log.fallback.width(0);
+    if (log.fallbackBuffer.size() > 0)
+        putString(std::string_view(log.fallbackBuffer.data(), log.fallbackBuffer.size()));
+    // Manipulator objects such as std::setw only change the state
+    log.fallback.width(width);
+    syncFormat();
+    fallbackWidth = width;
+}
+
+LogRecord& LogRecord::operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+    auto& log = threadLog;
+    log.fallbackUsed = true;
+    manipulator(log.fallback);
+    syncFormat();
+    fallbackWidth = log.fallback.width();
+    return *this;
+}
+
+void LogRecord::format(const char* data, size_t size, std::string& out) {
+    thread_local StringStreamBuf buffer;
+    thread_local std::ostream stream(&buffer);
+    thread_local const FormatState defaults = FormatState::of(stream);
+    buffer.target = &out;
+    defaults.apply(stream);
+    const size_t start = out.size();
+
+    auto read = [data](size_t at, auto& value) { std::memcpy(&value, data + at, sizeof(value)); };
+    size_t at = 0;
+    while (at < size) {
+        const auto tag = static_cast<Tag>(data[at++]);
+        switch (tag) {
+            case Tag::Signed: case Tag::Unsigned: case Tag::Floating: case Tag::Pointer: {
+                const auto numberSize = static_cast<uint8_t>(data[at++]);
+                if (tag == Tag::Signed) {
+                    int64_t value = 0;
+                    read(at, value);
+                    if (numberSize == sizeof(short)) stream << static_cast<short>(value);
+                    else if (numberSize == sizeof(int)) stream << static_cast<int>(value);
+                    else stream << static_cast<long long>(value);
+                    at += sizeof(value);
+                } else if (tag == Tag::Unsigned) {
+                    uint64_t value = 0;
+                    read(at, value);
+                    if (numberSize == sizeof(unsigned short)) stream << static_cast<unsigned short>(value);
+                    else if (numberSize == sizeof(unsigned)) stream << static_cast<unsigned>(value);
+                    else stream << static_cast<unsigned long long>(value);
+                    at += sizeof(value);
+                } else if (tag == Tag::Floating && numberSize == sizeof(float)) {
+                    float value = 0;
+                    read(at, value);
+                    stream << value;
+                    at += sizeof(value);
+                } else if (tag == Tag::Floating) {
+                    double value = 0;
+                    read(at, value);
+                    stream << value;
+                    at += sizeof(value);
+                } else {
+                    const void* value = nullptr;
+                    read(at, value);
+                    stream << value;
+                    at += sizeof(value);
+                }
+                break;
+            }
+            case Tag::Char:
+                stream << data[at++];
+                break;
+            case Tag::Bool: {
+                bool value = false;
+                read(at, value);
+                stream << value;
+                at += sizeof(value);
+                break;
+            }
+            case Tag::String: {
+                uint32_t length = 0;
+                read(at, length);
+                at += sizeof(length);
+                stream << std::string_view(data + at, length);
+                at += length;
+                break;
+            }
+            case Tag::Format: {
+                FormatState state = {};
+                read(at, state);
+                state.apply(stream);
+                at += sizeof(state);
+                break;
+            }
+        }
+    }
+    if (out.size() - start > capacity)
+        out.resize(start + capacity);
+}
+
+LogRecord& Logger::beginRecord() {
+    auto& log = threadLog;
+    log.record.reset();
+    if (log.fallbackUsed) {
+        log.defaults.apply(log.fallback);
+        log.fallback.clear();
+        log.emitted = log.defaults;
+        log.fallbackUsed = false;
+    }
+    return log.record;
+}
+
+void Logger::commitRecord(LogLevel level, LogSite* site) {
+    auto& log = threadLog;
+    const char* message = log.record.data();
+    const size_t size = log.record.getSize();
+
+    // Either the logger is gone already (static destruction) or this thread
+    // has no ring yet and the logger is being brought up
+    const Phase current = phase.load(std::memory_order_acquire);
+    if (current == Phase::Stopped) {
+        writeDirect(level, message, size);
+        return;
+    }
+    if (!log.ring)
+        log.ring = state().registerRing();
+    if (site && !site->registered.load(std::memory_order_relaxed))
+        state().registerSite(site);
+
+    if (level != LogLevel::Error) {
+        if (!log.ring->tryPush(level, site, message, size))
+            state().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Errors are never dropped and get written out without waiting for the next drain
+    while (!log.ring->tryPush(level, site, message, size)) {
+        if (phase.load(std::memory_order_acquire) == Phase::Stopped) {
+            writeDirect(level, message, size);
+            return;
+        }
+        std::this_thread::yield();
+    }
+    state().notifyUrgent();
+}
+
+void Logger::setThrottle(LogCategory category, LogThrottle throttle) {
+    auto& s = state();
+    std::lock_guard lock(s.mutex);
+    s.throttles[static_cast<int>(category)] = throttle;
+}
+
+void Logger::flush() {
+    if (phase.load(std::memory_order_acquire) != Phase::Running)
+        return;
+
+    auto& s = state();
+    std::unique_lock lock(s.mutex);
+    const uint64_t ticket = ++s.flushRequested;
+    s.wake.notify_one();
+    s.flushed.wait(lock, [&] { return s.flushCompleted >= ticket || s.stopping; });
+}
+
+uint64_t Logger::droppedRecords() {
+    if (phase.load(std::memory_order_acquire) == Phase::Unstarted)
+        return 0;
+    return state().dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// Records below this level are compiled out entirely, override with -DLOG_LEVEL=...
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warning,
+    Error,
+};
+
+// Throttling is configured per category, every throttled call site gets its own bucket
+enum class LogCategory : uint8_t {
+    General,
+    Frame,
+    GL,
+    Count,
+};
+
+struct LogThrottle {
+    float ratePerSecond;
+    int32_t burst;
+};
+
+// Token bucket of a single throttled call site. It is constant-initialized so
+// the function-local static in LOG_THROTTLED needs no guard, and the hot path
+// is one atomic decrement: a negative value counts suppressed messages, which
+// the logger thread collects when it refills the bucket.
+struct LogSite {
+    public:
+    constexpr LogSite(LogLevel level, LogCategory category, const char* file, int line)
+        : level(level), category(category), file(file), line(line) {}
+
+    [[nodiscard]] bool tryAcquire() { return tokens.fetch_sub(1, std::memory_order_relaxed) > 0; }
+
+    std::atomic<int32_t> tokens = 1;
+    std::atomic<bool> registered = false;
+    const LogLevel level;
+    const LogCategory category;
+    const char* const file;
+    const int line;
+
+    // Owned by the logger thread
+    uint32_t suppressed = 0;
+    float credit = 0;
+    int64_t lastReport = 0;
+};
+
+// Arguments of one log call, captured as tagged raw values. Numbers, chars,
+// strings and pointers are copied as they are and only formatted by the
+// logger thread; anything else goes through operator<< on the caller.
+// Stream manipulators are recorded as format state changes, so the output is
+// the same as streaming everything into one std::ostream.
+struct LogRecord {
+    public:
+    // Longer records are truncated
+    static constexpr size_t capacity = 4096;
+
+    enum class Tag : uint8_t {
+        Signed,   // Size byte, int64_t
+        Unsigned, // Size byte, uint64_t
+        Floating, // Size byte, float or double
+        Char,
+        Bool,
+        String,   // uint32_t length, bytes
+        Pointer,
+        Format,   // fmtflags, precision, width, fill
+    };
+
+    void reset() {
+        size = 0;
+        fallbackWidth = 0;
+    }
+
+    template<typename T>
+    LogRecord& operator<<(const T& value) {
+        using Type = std::remove_cv_t<T>;
+        // Pointers to any char type are C strings, as for std::ostream (GLubyte* included)
+        using Pointee = std::remove_cv_t<std::remove_pointer_t<std::decay_t<Type>>>;
+        constexpr bool cString = std::is_pointer_v<std::decay_t<Type>>
+            && (std::is_same_v<Pointee, char> || std::is_same_v<Pointee, signed char> || std::is_same_v<Pointee, unsigned char>);
+        if constexpr (std::is_same_v<Type, bool>) {
+            put(Tag::Bool, &value, 1);
+        } else if constexpr (std::is_same_v<Type, char> || std::is_same_v<Type, signed char> || std::is_same_v<Type, unsigned char>) {
+            put(Tag::Char, &value, 1);
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            putNumber(Tag::Signed, sizeof(Type), static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<Type>) {
+            putNumber(Tag::Unsigned, sizeof(Type), static_cast<uint64_t>(value));
+        } else if constexpr (std::is_same_v<Type, float>) {
+            putNumber(Tag::Floating, sizeof(float), value);
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            putNumber(Tag::Floating, sizeof(double), static_cast<double>(value));
+        } else if constexpr (std::is_array_v<Type> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<Type>>, char>) {
+            const std::string_view text(value, std::extent_v<Type>);
+            putString(text.substr(0, text.find('\0')));
+        } else if constexpr (cString) {
+            putString(value ? std::string_view(reinterpret_cast<const char*>(value)) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible_v<const Type&, std::string_view>) {
+            putString(std::string_view(value));
+        } else if constexpr (std::is_pointer_v<Type>) {
+            putNumber(Tag::Pointer, sizeof(const void*), static_cast<const void*>(value));
+        } else {
+            std::ostream& stream = beginFallback();
+            stream << value;
+            endFallback();
+        }
+        return *this;
+    }
+
+    // std::hex, std::fixed and friends
+    LogRecord& operator<<(std::ios_base& (*manipulator)(std::ios_base&));
+
+    [[nodiscard]] const char* data() const { return bytes; }
+    [[nodiscard]] size_t getSize() const { return size; }
+
+    // Appends the formatted record to out, at most capacity bytes of it
+    static void format(const char* data, size_t size, std::string& out);
+
+    private:
+    void put(Tag tag, const void* value, size_t length) {
+        if (size + 1 + length > capacity)
+            return;
+        bytes[size] = static_cast<char>(tag);
+        std::memcpy(bytes + size + 1, value, length);
+        size += 1 + length;
+        if (tag != Tag::Format)
+            consumeWidth();
+    }
+
+    template<typename Number>
+    void putNumber(Tag tag, uint8_t numberSize, Number value) {
+        if (size + 2 + sizeof(value) > capacity)
+            return;
+        bytes[size] = static_cast<char>(tag);
+        bytes[size + 1] = static_cast<char>(numberSize);
+        std::memcpy(bytes + size + 2, &value, sizeof(value));
+        size += 2 + sizeof(value);
+        consumeWidth();
+    }
+
+    void putString(std::string_view text);
+
+    // Formatting a value resets the stream's width, mirror that for values
+    // captured raw so a fallback value later on does not pick it up again
+    void consumeWidth() {
+        if (fallbackWidth)
+            resetFallbackWidth();
+    }
+    void resetFallbackWidth();
+
+    std::ostream& beginFallback();
+    void endFallback();
+    // Records the fallback stream's state if the logger thread would not have it
+    void syncFormat();
+
+    char bytes[capacity];
+    size_t size = 0;
+    std::streamsize fallbackWidth = 0; // Width set on the fallback stream and not consumed yet
+};
+
+// Asynchronous logger. Call sites capture their arguments into a thread-local
+// LogRecord and push it into a per-thread lock-free ring; a background thread
+// drains all rings, formats the records and writes them out in batches, so
+// the caller neither formats numbers nor does a syscall.
+struct Logger {
+    public:
+    // Longer messages are truncated
+    static constexpr size_t maxMessageSize = LogRecord::capacity;
+
+    // Returns the calling thread's record, reset and ready for new arguments
+    static LogRecord& beginRecord();
+    // Pushes whatever was captured since beginRecord()
+    static void commitRecord(LogLevel level, LogSite* site = nullptr);
+
+    // Rate limit for every throttled call site of the category
+    static void setThrottle(LogCategory category, LogThrottle throttle);
+
+    // Blocks until every record committed before the call has been written
+    static void flush();
+    // Records dropped because a ring was full (errors are never dropped)
+    static uint64_t droppedRecords();
+};
+
+#define LOG_RECORD(level, x) do { \
+    LogRecord& _logRecord = Logger::beginRecord(); \
+    _logRecord << x; \
+    Logger::commitRecord(level); \
+} while (0);
+
+#define LOG_THROTTLED(level, category, x) do { \
+    static LogSite _logSite(level, category, __FILE__, __LINE__); \
+    if (_logSite.tryAcquire()) { \
+        LogRecord& _logRecord = Logger::beginRecord(); \
+        _logRecord << x; \
+        Logger::commitRecord(level, &_logSite); \
+    } \
+} while (0);
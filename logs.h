@@ -1,8 +1,38 @@
-#include <iostream>
-
 #pragma once
 
-#define info(x) std::cout << "INFO: " << x << std::endl;
-#define debug(x) std::cout << "DEBUG: " << x << std::endl;
-#define warning(x) std::cout << "WARN: " << x << std::endl;
-#define error(x) std::cerr << "ERRO: " << x << std::endl;
+#include "logger.h"
+
+// The *_throttled variants are rate limited per call site according to the
+// category's LogThrottle, suppressed calls are reported in a later message.
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define debug(x) LOG_RECORD(LogLevel::Debug, x)
+#define debug_throttled(category, x) LOG_THROTTLED(LogLevel::Debug, category, x)
+#else
+#define debug(x) do {} while (0);
+#define debug_throttled(category, x) do {} while (0);
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define info(x) LOG_RECORD(LogLevel::Info, x)
+#define info_throttled(category, x) LOG_THROTTLED(LogLevel::Info, category, x)
+#else
+#define info(x) do {} while (0);
+#define info_throttled(category, x) do {} while (0);
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
+#define warning(x) LOG_RECORD(LogLevel::Warning, x)
+#define warning_throttled(category, x) LOG_THROTTLED(LogLevel::Warning, category, x)
+#else
+#define warning(x) do {} while (0);
+#define warning_throttled(category, x) do {} while (0);
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define error(x) LOG_RECORD(LogLevel::Error, x)
+#define error_throttled(category, x) LOG_THROTTLED(LogLevel::Error, category, x)
+#else
+#define error(x) do {} while (0);
+#define error_throttled(category, x) do {} while (0);
+#endif
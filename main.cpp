@@ -1,8 +1,12 @@
+#include <algorithm>
 #include <fstream>
 #include <cstddef>
+#include <cstring>
 #include <cmath>
 #include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -10,26 +14,100 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "dashboard.h"
+#include "font_cache.h"
+#include "frame_arena.h"
+#include "gl_debug.h"
+#include "gl_state.h"
+#include "gpu_buffer_allocator.h"
+#include "gpu_resources.h"
+#include "imgui_renderer.h"
 #include "logs.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+#include "mesh_optimizer.h"
+#include "memory.h"
+#include "output_window.h"
+#include "pacing.h"
+#include "params.h"
 #include "vertex.h"
 #include "program.h"
+#include "residency.h"
+#include "stats.h"
+#include "upload_manager.h"
+#include "trace.h"
+#include "ui_cache.h"
 
-const size_t WIDTH = 800;
-const size_t HEIGHT = 800;
 const char* WINDOW_TITLE = "Test OpenGL";
-const unsigned int TARGET_FRAMERATE = 60;
+const char* TRACE_PREFIX = "trace";
+const int OUTPUT_WINDOW_WIDTH = 480;
+const int OUTPUT_WINDOW_HEIGHT = 360;
+const char* FONT_CACHE_PATH = "imgui_fonts.cache";
+const FontSpec FONTS[] = {
+    {nullptr, 13.0f},
+};
+
+// State reachable from GLFW callbacks through the window user pointer
+struct App {
+    // ImGui needs a couple of frames to settle after input (hover, popups)
+    static constexpr int framesAfterInvalidate = 3;
+
+    Dashboard dashboard;
+    bool showTuning = false;
+    UiCache uiCache;
+    int pendingFrames = framesAfterInvalidate; // Frames still owed to idle mode
+    // Framebuffer size in pixels, which differs from the window size with HiDPI scaling
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+    bool framebufferResized = true;
+
+    void invalidate() {
+        pendingFrames = framesAfterInvalidate;
+        uiCache.markDirty();
+    }
+};
+
+// Any input may change what is on screen. ImGui's GLFW backend chains to the
+// callbacks installed before it, so these see every event as well.
+static void invalidate(GLFWwindow* window) {
+    if (auto app = static_cast<App*>(glfwGetWindowUserPointer(window)))
+        app->invalidate();
+}
 
 static void keyCallback(GLFWwindow *window, int key, int, int action, int) {
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+    invalidate(window);
+    if (action != GLFW_PRESS)
+        return;
+
+    auto app = static_cast<App*>(glfwGetWindowUserPointer(window));
+    if (key == GLFW_KEY_ESCAPE)
         glfwSetWindowShouldClose(window, GLFW_TRUE);
+    else if (key == GLFW_KEY_F1 && app)
+        app->dashboard.visible = !app->dashboard.visible;
+    else if (key == GLFW_KEY_F2 && app)
+        app->dashboard.showDemoWindow = !app->dashboard.showDemoWindow;
+    else if (key == GLFW_KEY_F3 && app)
+        app->showTuning = !app->showTuning;
 }
 
-GLFWwindow* initWindow() {
+static void framebufferSizeCallback(GLFWwindow* window, int width, int height) {
+    invalidate(window);
+    if (auto app = static_cast<App*>(glfwGetWindowUserPointer(window))) {
+        app->framebufferWidth = width;
+        app->framebufferHeight = height;
+        app->framebufferResized = true;
+    }
+}
+
+GLFWwindow* initWindow(int width, int height, bool visible) {
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_DEBUG ? GLFW_TRUE : GLFW_FALSE);
 
-    auto window = glfwCreateWindow(WIDTH, HEIGHT, WINDOW_TITLE, NULL, NULL);
+    auto window = glfwCreateWindow(width, height, WINDOW_TITLE, NULL, NULL);
     if (!window) {
         error("Could not open window with GLFW3");
         glfwTerminate();
@@ -37,18 +115,294 @@ GLFWwindow* initWindow() {
     }
 
     glfwSetKeyCallback(window, keyCallback);
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { invalidate(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { invalidate(w); });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { invalidate(w); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow* w, int) { invalidate(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { invalidate(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { invalidate(w); });
+    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { invalidate(w); });
     glfwMakeContextCurrent(window);
 
     return window;
 }
 
-void initImGui(GLFWwindow* window) {
+bool initImGui(GLFWwindow* window) {
     IMGUI_CHECKVERSION();
+    // Routed through the heap counters, ImGui would use malloc directly otherwise
+    ImGui::SetAllocatorFunctions(imguiAllocate, imguiFree);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+    if (!loadFontAtlas(io.Fonts, FONTS, sizeof(FONTS) / sizeof(*FONTS), FONT_CACHE_PATH))
+        return false;
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init();
+    return true;
+}
+
+// The stock ImGui backend draws and uploads behind GlState's back
+void countImGuiWork(const ImDrawData* drawData) {
+    auto& counters = frameCounters();
+    for (int i = 0; i < drawData->CmdListsCount; i++)
+        counters.drawCalls += drawData->CmdLists[i]->CmdBuffer.Size;
+    counters.triangles += drawData->TotalIdxCount / 3;
+    counters.bytesUploaded += drawData->TotalVtxCount * sizeof(ImDrawVert) + drawData->TotalIdxCount * sizeof(ImDrawIdx);
+    counters.uploadCalls += 2 * drawData->CmdListsCount;
+}
+
+void renderImGui(GlState& gl, ImGuiRenderer& renderer, int backend, ImDrawData* drawData) {
+    if (backend == Params::UiStreaming) {
+        renderer.render(gl, drawData);
+        return;
+    }
+    ImGui_ImplOpenGL3_RenderDrawData(drawData);
+    countImGuiWork(drawData);
+}
+
+// Spins the triangle around the origin and shifts its colors with the angle
+void animateTriangle(vertex* vertices, float angle) {
+    for (int i = 0; i <= 2; i++) {
+        // Rotate the triangle
+        float rotationOffset = (360.0f / 3) * i;
+        float degrees = std::fmod(angle + rotationOffset, 360.0f);
+        auto radians = degrees * M_PI / 180;
+        float distanceFromCenter = 0.5;
+        vertices[i][0] = distanceFromCenter * sin(radians);
+        vertices[i][1] = distanceFromCenter * cos(radians);
+
+        // Color shift, kinda working
+        float cyclePercent = (-cos(radians) + 1) / 2;
+        for (int j = 0; j <= 2; j++) {
+            float colorAmount = ((i + j + 1) % 3);
+            vertices[i][3 + j] = (1.0f / 3) * colorAmount * 1.0f * cyclePercent;
+        }
+    }
+}
+
+void uploadVertices(GlState& gl, UploadManager& uploads, int strategy, GLuint buffer, const vertex* vertices, GLsizeiptr size) {
+    if (strategy == Params::Staged) {
+        uploads.queueBuffer(buffer, 0, vertices, size);
+        return;
+    }
+    gl.bindBuffer(GL_ARRAY_BUFFER, buffer);
+    switch (strategy) {
+        case Params::BufferData:
+            gl.bufferData(GL_ARRAY_BUFFER, size, vertices, GL_STREAM_DRAW);
+            break;
+        case Params::BufferSubData:
+            gl.bufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+            break;
+        case Params::Orphan:
+            gl.bufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            gl.bufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
+            break;
+        case Params::MapRange:
+            gl.mapBufferWrite(GL_ARRAY_BUFFER, 0, size, vertices, GL_MAP_INVALIDATE_BUFFER_BIT);
+            break;
+    }
+}
+
+// Returns the mode that was applied, adaptive vsync needs the tear control extension
+int applyPresentMode(int mode) {
+    const bool tearControl = glfwExtensionSupported("GLX_EXT_swap_control_tear")
+        || glfwExtensionSupported("WGL_EXT_swap_control_tear");
+    if (mode == Params::PresentAdaptive && !tearControl) {
+        warning("Adaptive vsync is not supported, using regular vsync");
+        mode = Params::PresentOn;
+    }
+    glfwSwapInterval(mode == Params::PresentOff ? 0 : mode == Params::PresentOn ? 1 : -1);
+    return mode;
+}
+
+// Refresh rate of the primary monitor, the window lives there more often than not
+double refreshRate() {
+    auto monitor = glfwGetPrimaryMonitor();
+    auto mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return mode && mode->refreshRate > 0 ? mode->refreshRate : 60.0;
+}
+
+// Opens or closes output windows to match count, windows the user closed are
+// dropped for good. Returns how many are open and leaves the main context current.
+size_t syncOutputWindows(
+    std::vector<std::unique_ptr<OutputWindow>>& outputs, size_t count, GLFWwindow* window
+) {
+    const size_t before = outputs.size();
+    outputs.erase(
+        std::remove_if(outputs.begin(), outputs.end(), [](const auto& output) { return !output->isOpen(); }),
+        outputs.end()
+    );
+    bool changed = outputs.size() != before;
+    if (changed)
+        count = std::min(count, outputs.size());
+
+    while (outputs.size() > count) {
+        outputs.pop_back();
+        changed = true;
+    }
+    while (outputs.size() < count) {
+        auto output = std::make_unique<OutputWindow>();
+        const int index = static_cast<int>(outputs.size()) + 1;
+        changed = true;
+        if (!output->init(window, index, OUTPUT_WINDOW_WIDTH, OUTPUT_WINDOW_HEIGHT))
+            break;
+        outputs.push_back(std::move(output));
+    }
+
+    if (changed)
+        glfwMakeContextCurrent(window);
+    return outputs.size();
+}
+
+// Indexed mesh in two buffers owned by the residency manager, which reloads
+// them from the CPU copy kept here after evicting them
+struct StreamedMesh {
+    std::vector<char> vertices;
+    std::vector<char> indices;
+    GLenum indexType = GL_UNSIGNED_INT;
+    GLsizei indexCount = 0;
+    uint32_t vertexHandle = 0; // 0 when not streamed
+    uint32_t indexHandle = 0;
+    GpuVertexArray vertexArray;
+    // Buffers the vertex array points at, 0 after a frame they were not resident
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+
+    [[nodiscard]] size_t getSize() const { return vertices.size() + indices.size(); }
+};
+
+bool copyBlob(void* userData, void* destination, size_t size) {
+    const auto& blob = *static_cast<const std::vector<char>*>(userData);
+    if (blob.size() != size)
+        return false;
+    std::memcpy(destination, blob.data(), size);
+    return true;
+}
+
+void streamMesh(ResidencyManager& residency, const MeshView& view, StreamedMesh& mesh) {
+    if (!view.indices || view.indexCount == 0)
+        return;
+    const size_t indexSize = view.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const auto vertices = static_cast<const char*>(view.vertices);
+    const auto indices = static_cast<const char*>(view.indices);
+    mesh.vertices.assign(vertices, vertices + view.vertexCount * sizeof(vertex));
+    mesh.indices.assign(indices, indices + view.indexCount * indexSize);
+    mesh.indexType = view.indexType;
+    mesh.indexCount = static_cast<GLsizei>(view.indexCount);
+    mesh.vertexHandle = residency.add(mesh.vertices.size(), 0, copyBlob, &mesh.vertices);
+    mesh.indexHandle = residency.add(mesh.indices.size(), 0, copyBlob, &mesh.indices);
+    mesh.vertexArray = gpuResources().create<GpuResourceType::VertexArray>();
+}
+
+void streamMesh(ResidencyManager& residency, const MeshData& data, StreamedMesh& mesh) {
+    streamMesh(
+        residency, {data.vertices.data(), data.vertexCount(), data.indices.data(), data.indices.size(), GL_UNSIGNED_INT},
+        mesh
+    );
+}
+
+// Draws nothing until both buffers are resident, use() queues their loads.
+// Returns the draw for output windows.
+MeshDraw drawStreamedMesh(GlState& gl, ResidencyManager& residency, StreamedMesh& mesh, GLsizei instances) {
+    const GLuint vertexBuffer = residency.use(mesh.vertexHandle);
+    const GLuint indexBuffer = residency.use(mesh.indexHandle);
+    if (!vertexBuffer || !indexBuffer) {
+        // A reloaded buffer may get the name of the evicted one, so its
+        // arrival is told by this frame without it rather than by the name
+        mesh.vertexBuffer = 0;
+        mesh.indexBuffer = 0;
+        return {};
+    }
+    if (vertexBuffer != mesh.vertexBuffer || indexBuffer != mesh.indexBuffer) {
+        setupVertexArray(mesh.vertexArray.id(), vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        gl.invalidate();
+        mesh.vertexBuffer = vertexBuffer;
+        mesh.indexBuffer = indexBuffer;
+    }
+    gl.bindVertexArray(mesh.vertexArray.id());
+    gl.drawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0, 0, instances);
+    return {vertexBuffer, indexBuffer, mesh.indexType, mesh.indexCount, 0, 0};
+}
+
+// A sample mesh as loaded and welded, built the first time it is drawn.
+// Imported files are indexed already and have no soup. With --stream-meshes
+// the indexed mesh is streamed instead of uploaded.
+struct SampleMesh {
+    Mesh soup;
+    Mesh indexed;
+    StreamedMesh streamed;
+    bool loaded = false;
+};
+
+// `residency` is null unless meshes are streamed
+void loadMeshFile(
+    GlState& gl, GpuBufferAllocator& buffers, ResidencyManager* residency, const std::string& path, bool useCache,
+    SampleMesh& sample
+) {
+    sample.loaded = true;
+    if (path.empty()) {
+        warning("--mesh file needs --mesh-file");
+        return;
+    }
+    const std::string cachePath = meshCachePath(path.c_str());
+    const auto start = std::chrono::steady_clock::now();
+    MeshCache cache;
+    if (useCache && cache.open(cachePath.c_str(), path.c_str())) {
+        const auto view = cache.view();
+        if (residency)
+            streamMesh(*residency, view, sample.streamed);
+        else
+            sample.indexed.upload(gl, buffers, view, path.c_str());
+        const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        info(
+            "Loaded " << path << " from " << cachePath << ": " << view.vertexCount << " vertices, "
+            << view.indexCount / 3 << " triangles in " << ms << " ms"
+        );
+        return;
+    }
+    MeshData data;
+    ImportStats import = {};
+    if (!importMesh(path.c_str(), data, &import))
+        return;
+    const MeshOptimizeStats optimize = optimizeMesh(data);
+    if (residency)
+        streamMesh(*residency, data, sample.streamed);
+    else
+        sample.indexed.upload(gl, buffers, data, path.c_str());
+    info(
+        "Imported " << path << ": " << import.vertices << " vertices, " << import.triangles << " triangles, "
+        << import.bytes / (import.ms * 1e6f) << " GB/s on " << import.threads << " threads, optimized to ACMR "
+        << optimize.after.acmr << " in " << optimize.ms << " ms"
+    );
+    if (useCache)
+        writeMeshCache(cachePath.c_str(), path.c_str(), data);
+}
+
+void loadSampleMesh(GlState& gl, GpuBufferAllocator& buffers, ResidencyManager* residency, int which, SampleMesh& sample) {
+    const bool sphere = which == Params::MeshSphere;
+    const std::string name = sphere ? "sphere" : "grid";
+    MeshData data = sphere ? sphereSoup(192, 256) : gridSoup(256);
+    sample.soup.upload(gl, buffers, data, (name + " soup").c_str());
+    const WeldStats weld = weldVertices(data);
+    const MeshOptimizeStats optimize = optimizeMesh(data);
+    if (residency)
+        streamMesh(*residency, data, sample.streamed);
+    else
+        sample.indexed.upload(gl, buffers, data, name.c_str());
+    sample.loaded = true;
+    info(
+        "Welded the " << name << ": " << weld.inputVertices << " -> " << weld.outputVertices << " vertices ("
+        << 100 - weld.outputVertices * 100 / std::max<size_t>(weld.inputVertices, 1) << "% fewer) in " << weld.ms
+        << " ms on " << weld.threads << " threads, " << sample.soup.getSize() / 1024 << " -> "
+        << (residency ? sample.streamed.getSize() : sample.indexed.getSize()) / 1024 << " KiB"
+    );
+    info(
+        "Optimized the " << name << ": ACMR " << optimize.before.acmr << " -> " << optimize.after.acmr << ", ATVR "
+        << optimize.before.atvr << " -> " << optimize.after.atvr << ", " << optimize.triangles / (optimize.ms * 1000)
+        << " M triangles/s on " << optimize.threads << " threads"
+    );
 }
 
 std::string readFile(const char* path) {
@@ -65,13 +419,35 @@ std::string readFile(const char* path) {
     return out;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    auto params = Params();
+    auto registry = ParamRegistry();
+    registerParams(registry, params);
+    if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")) {
+        registry.printUsage(argv[0]);
+        return 0;
+    }
+    if (!registry.parseArguments(argc, argv)) {
+        registry.printUsage(argv[0]);
+        return 1;
+    }
+
+    // Per-frame events are cheap enough to always be on, decode with tools/trace_decode.
+    // Opened early so startup costs like the font atlas end up in it too.
+    if (!Trace::open(TRACE_PREFIX)) {
+        warning("Tracing disabled");
+    }
+
+    if (!frameArena().init(static_cast<size_t>(params.frameArenaSize) * 1024, params.hugePages)) {
+        warning("Frame scratch data goes to the heap");
+    }
+
     if (!glfwInit()) {
         error("Could not initialize GLFW3");
         return -1;
     }
 
-    auto window = initWindow();
+    auto window = initWindow(params.windowWidth, params.windowHeight, !params.headless);
     if (!window) {
         glfwTerminate();
         return -1;
@@ -82,13 +458,21 @@ int main() {
         return -1;
     }
 
-    initImGui(window);
+    installGlDebugOutput(GL_DEBUG_SEVERITY_LOW);
 
-    glViewport(0, 0, WIDTH, HEIGHT);
+    if (!initImGui(window)) {
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwSetWindowSize(window, params.windowWidth, params.windowHeight);
+    applyPresentMode(params.presentMode);
+    const double monitorRefreshRate = refreshRate();
 
     info("Renderer: " << glGetString(GL_RENDERER));
     info("OpenGL version: " << glGetString(GL_VERSION));
     info("ImGui version: "<< ImGui::GetVersion());
+    info("Refresh rate: " << monitorRefreshRate << "Hz");
 
     // Register program and shaders
     auto program = Program();
@@ -108,6 +492,9 @@ int main() {
         glfwTerminate();
         return -1;
     }
+    labelGlObject(GL_PROGRAM, program.getId(), "triangle program");
+    const GLint instanceCountLocation = glGetUniformLocation(program.getId(), "instanceCount");
+    glUniform1i(instanceCountLocation, params.instanceCount);
 
     // Triangle vertices
     vertex vertices[] = {
@@ -120,87 +507,252 @@ int main() {
 
 
     // Vertex Buffer Object = VBO
-    GLuint VBO = {};
-    glGenBuffers(1, &VBO);
-    if (glGetError() != GL_NO_ERROR) {
+    auto vertexBuffer = gpuResources().create<GpuResourceType::Buffer>();
+    const GLuint VBO = vertexBuffer.id();
+    if (!VBO || !checkGlError("glGenBuffers")) {
         error("Couldn't generate buffers");
         glfwTerminate();
         return -1;
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    labelGlObject(GL_BUFFER, VBO, "triangle vertices");
     glBufferData(GL_ARRAY_BUFFER, drawBufferSize, vertices, GL_STATIC_DRAW | GL_MAP_READ_BIT);
+    vertexBuffer.setMemory(drawBufferSize);
 
     // Vertex Arrays Object = VAO
-    GLuint VAO = {};
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    // Specify position attribute -> 0 as offset
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (GLvoid *)0);
-    glEnableVertexAttribArray(0);
+    auto vertexArray = gpuResources().create<GpuResourceType::VertexArray>();
+    const GLuint VAO = vertexArray.id();
+    setupVertexArray(VAO, VBO);
+    labelGlObject(GL_VERTEX_ARRAY, VAO, "triangle");
+
+    const TraceEvent<uint32_t, float, float, float, float, uint32_t> frameEvent(
+        "frame", {"index", "frameMs", "sleepMs", "swapMs", "latencyMs", "allocations"}
+    );
+
+    GlState gl;
+    FrameProfiler profiler;
+    ActivityMeter activity;
+    FramePacer pacer;
+    AllocationAudit allocationAudit(params.allocationBudget, params.allocationWarmup);
+    std::vector<std::unique_ptr<OutputWindow>> outputs;
+    GpuBufferAllocator meshBuffers("mesh buffer");
+    SampleMesh sampleMeshes[3];
+    ResidencyManager residency;
+    UploadManager uploads;
+    App app;
+    glfwSetWindowUserPointer(window, &app);
+    // The callback only reports changes from here on
+    glfwGetFramebufferSize(window, &app.framebufferWidth, &app.framebufferHeight);
+
+    auto uiVertexSource = readFile("shaders/ui_vertex.glsl");
+    auto uiFragmentSource = readFile("shaders/ui_fragment.glsl");
+    if (!app.uiCache.init(uiVertexSource.c_str(), uiFragmentSource.c_str())) {
+        glfwTerminate();
+        return -1;
+    }
 
-    // Specify color attribute -> 3 as offset
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (GLvoid *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    ImGuiRenderer uiRenderer;
+    auto imguiVertexSource = readFile("shaders/imgui_vertex.glsl");
+    auto imguiFragmentSource = readFile("shaders/imgui_fragment.glsl");
+    if (!uiRenderer.init(gl, imguiVertexSource.c_str(), imguiFragmentSource.c_str())) {
+        glfwTerminate();
+        return -1;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // Last values pushed to GLFW/GL, compared against params every frame
+    auto applied = params;
+    float angle = 0;
+    double lastFrameTime = glfwGetTime();
 
     unsigned int frame = 0;
     while (!glfwWindowShouldClose(window)) {
-        auto start = std::chrono::high_resolution_clock::now();
+        // Idle mode blocks for events instead of polling while nothing on screen changes
+        if (params.idle && params.animationMode == Params::Static && app.pendingFrames == 0) {
+            if (params.idleTimeout > 0)
+                glfwWaitEventsTimeout(params.idleTimeout / 1000.0);
+            else
+                glfwWaitEvents();
+            if (app.pendingFrames == 0) {
+                activity.frame(false);
+                continue;
+            }
+        }
 
+        auto start = FramePacer::Clock::now();
+        frameArena().beginFrame();
+        gpuResources().beginFrame(frame);
+        const double now = glfwGetTime();
+        const float deltaTime = static_cast<float>(now - lastFrameTime);
+        lastFrameTime = now;
+        registry.setFrame(frame);
+        // GPU timer queries are only worth it when someone is looking
+        profiler.beginFrame(frame, app.dashboard.visible);
+
+        profiler.beginPhase(FramePhase::Events);
         glfwPollEvents();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        ImGui::ShowDemoWindow(); // Show demo window! :)
+        // The cached UI is only rebuilt when something could have changed it
+        const bool uiCached = params.uiMode == Params::UiCached;
+        const bool uiUpdate = !uiCached || app.uiCache.needsUpdate(now, params.uiRefreshRate);
+
+        profiler.beginPhase(FramePhase::Ui);
+        if (uiUpdate) {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            app.dashboard.draw();
+            registry.drawPanel(&app.showTuning);
+        }
 
+        if (params.presentMode != applied.presentMode)
+            applyPresentMode(params.presentMode);
+        if (params.windowWidth != applied.windowWidth || params.windowHeight != applied.windowHeight)
+            glfwSetWindowSize(window, params.windowWidth, params.windowHeight);
+        if (params.instanceCount != applied.instanceCount) {
+            gl.useProgram(program.getId());
+            glUniform1i(instanceCountLocation, params.instanceCount);
+        }
+        if (params.uiMode != applied.uiMode)
+            app.uiCache.markDirty();
+        const size_t openOutputs = syncOutputWindows(outputs, params.outputCount, window);
+        if (openOutputs != static_cast<size_t>(params.outputCount))
+            registry.set("outputs", std::to_string(openOutputs));
+        applied = params;
+
+        profiler.beginPhase(FramePhase::Scene);
+        // Before any use() this frame, so eviction spares what the last frame drew
+        residency.setLimits(static_cast<size_t>(params.gpuBudget) << 20, static_cast<size_t>(params.streamRate) << 20);
+        residency.update(gl, frame);
+        if (app.framebufferResized) {
+            glViewport(0, 0, app.framebufferWidth, app.framebufferHeight);
+            app.framebufferResized = false;
+        }
         glClearColor(0, 0, 0, 1.0);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(program.getId());
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-
-        for (int i = 0; i <= 2; i++) {
-            // Rotate the triangle
-            unsigned int rotationOffset = (360 / 3) * i;
-            float degrees = (frame + rotationOffset) % 360;
-            auto radians = degrees * M_PI / 180;
-            float distanceFromCenter = 0.5;
-            vertices[i][0] = distanceFromCenter * sin(radians);
-            vertices[i][1] = distanceFromCenter * cos(radians);
-
-            // Color shift, kinda working
-            float cyclePercent = (-cos(radians) + 1) / 2;
-            for (int j = 0; j <= 2; j++) {
-                float colorAmount = ((i + j + 1) % 3);
-                vertices[i][3 + j] = (1.0f / 3) * colorAmount * 1.0f * cyclePercent;
+        gl.useProgram(program.getId());
+        // What output windows draw, a mesh's ranges are only looked up then
+        // since compaction may still move them this frame
+        MeshDraw scene = {VBO, 0, GL_UNSIGNED_INT, static_cast<GLsizei>(vertexCount), 0, 0};
+        const Mesh* sceneMesh = nullptr;
+        if (params.sceneMesh == Params::MeshTriangle) {
+            gl.bindVertexArray(VAO);
+            gl.drawArrays(GL_TRIANGLES, 0, vertexCount, params.instanceCount);
+        } else {
+            auto& sample = sampleMeshes[params.sceneMesh - Params::MeshSphere];
+            ResidencyManager* streaming = params.streamMeshes ? &residency : nullptr;
+            if (!sample.loaded && params.sceneMesh == Params::MeshFile)
+                loadMeshFile(gl, meshBuffers, streaming, params.meshFile, params.meshCache, sample);
+            else if (!sample.loaded)
+                loadSampleMesh(gl, meshBuffers, streaming, params.sceneMesh, sample);
+            const bool indexed = params.indexed || params.sceneMesh == Params::MeshFile;
+            if (indexed && sample.streamed.vertexHandle) {
+                scene = drawStreamedMesh(gl, residency, sample.streamed, params.instanceCount);
+            } else {
+                sceneMesh = indexed ? &sample.indexed : &sample.soup;
+                sceneMesh->draw(gl, params.instanceCount);
             }
-
-            // debug('[' << i << "] (" << vertices[i][3] << ", " << vertices[i][4] << ", " << vertices[i][5] << ")");
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, drawBufferSize, vertices, GL_STATIC_DRAW | GL_MAP_READ_BIT);
-
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler.beginPhase(FramePhase::Upload);
+        if (params.animationMode != Params::Static) {
+            // One degree per frame, or the same speed at 60 FPS when following the clock
+            angle += params.animationMode == Params::PerFrame ? 1.0f : 60.0f * deltaTime;
+            angle = std::fmod(angle, 360.0f);
+            // Staging copy, only needed until the upload returns
+            vertex* animated = frameArena().allocateArray<vertex>(vertexCount);
+            std::memcpy(animated, vertices, drawBufferSize);
+            animateTriangle(animated, angle);
+
+            uploadVertices(gl, uploads, params.uploadStrategy, VBO, animated, drawBufferSize);
+        }
+        uploads.setBudget(static_cast<size_t>(params.uploadBudget) * 1024);
+        uploads.flush(gl);
+
+        if (params.compactBudget > 0)
+            meshBuffers.compact(gl, static_cast<size_t>(params.compactBudget) * 1024);
+
+        profiler.beginPhase(FramePhase::UiRender);
+        if (uiUpdate) {
+            ImGui::Render();
+            if (uiCached) {
+                app.uiCache.beginRender(gl, app.framebufferWidth, app.framebufferHeight);
+                renderImGui(gl, uiRenderer, params.uiRenderer, ImGui::GetDrawData());
+                app.uiCache.endRender(gl, now);
+            } else {
+                renderImGui(gl, uiRenderer, params.uiRenderer, ImGui::GetDrawData());
+            }
+            frameCounters().uiRedraws++;
+        }
+        if (uiCached)
+            app.uiCache.composite(gl);
+
+        profiler.beginPhase(FramePhase::Outputs);
+        if (!outputs.empty()) {
+            GLsync uploaded = nullptr;
+            // Meshes may have been loaded, streamed in or compacted this frame
+            if (params.animationMode != Params::Static || params.sceneMesh != Params::MeshTriangle) {
+                uploaded = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                // Other contexts wait for the fence, so it has to reach the GPU first
+                glFlush();
+            }
+            if (sceneMesh)
+                scene = sceneMesh->drawCall();
+            for (auto& output : outputs)
+                output->render(program.getId(), scene, params.instanceCount, uploaded);
+            glfwMakeContextCurrent(window);
+            if (uploaded)
+                glDeleteSync(uploaded);
+        }
 
+        profiler.beginPhase(FramePhase::Swap);
         glfwSwapBuffers(window);
+        // Drivers may return from the swap before the vblank, which would
+        // throw off both the latency and the just in time schedule
+        const bool justInTime = params.justInTime && params.presentMode != Params::PresentOff;
+        if (justInTime)
+            glFinish();
+        const auto presented = FramePacer::Clock::now();
+        const auto frameStats = profiler.endFrame();
+        pacer.recordWork(frameStats.frameMs - frameStats.cpuMs[static_cast<int>(FramePhase::Swap)]);
+        app.dashboard.record(frameStats);
+        allocationAudit.record(frameStats);
+        activity.frame(true);
+        app.dashboard.record(activity.lastSecond());
+        app.dashboard.record(meshBuffers.stats());
+        app.dashboard.record(residency.stats());
+        app.dashboard.record(uploads.stats());
+        if (app.pendingFrames > 0)
+            app.pendingFrames--;
 
         using std::chrono::duration_cast;
         using std::chrono::microseconds;
         using std::chrono::milliseconds;
 
-        auto frameTime = std::chrono::high_resolution_clock::now() - start;
-        auto targetFrameTime = milliseconds(1000) / TARGET_FRAMERATE;
-        if (frameTime < targetFrameTime) {
-            std::this_thread::sleep_for(targetFrameTime - frameTime);
-        } else {
-            warning(
+        const auto end = FramePacer::Clock::now();
+        auto frameTime = end - start;
+        auto targetFrameTime = params.frameCap > 0
+            ? std::chrono::duration_cast<decltype(frameTime)>(milliseconds(1000)) / params.frameCap
+            : decltype(frameTime)::zero();
+        const auto nextStart = pacer.nextFrameStart(
+            start, presented, params.frameCap, justInTime, monitorRefreshRate, params.justInTimeMargin
+        );
+        auto sleepTime = nextStart - end;
+        frameEvent(
+            frame,
+            duration_cast<microseconds>(frameTime).count() / 1000.0f,
+            duration_cast<microseconds>(std::max(sleepTime, decltype(sleepTime)::zero())).count() / 1000.0f,
+            frameStats.cpuMs[static_cast<int>(FramePhase::Swap)],
+            frameStats.latencyMs,
+            static_cast<uint32_t>(frameStats.heap.allocations)
+        );
+        if (sleepTime > decltype(sleepTime)::zero()) {
+            std::this_thread::sleep_for(sleepTime);
+        }
+        if (frameTime > targetFrameTime && params.frameCap > 0) {
+            warning_throttled(
+                LogCategory::Frame,
                 "Frame took longer than "
                 << duration_cast<milliseconds>(targetFrameTime).count() << "ms: "
                 << duration_cast<microseconds>(frameTime).count() / 1000.0f << "ms"
@@ -208,14 +760,36 @@ int main() {
         }
 
         frame++;
+        if (params.frameLimit > 0 && frame >= static_cast<unsigned int>(params.frameLimit))
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 
+    outputs.clear();
+    glfwMakeContextCurrent(window);
+    app.uiCache.destroy();
+    uiRenderer.destroy();
+    profiler.destroy();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
+    Trace::close();
+
+    for (auto& sample : sampleMeshes) {
+        sample.soup.destroy();
+        sample.indexed.destroy();
+        sample.streamed.vertexArray.reset();
+    }
+    meshBuffers.destroy();
+    residency.destroy();
+    uploads.destroy();
+    vertexBuffer.reset();
+    vertexArray.reset();
+    program.destroy();
+    // Everything registered is released by now, shutdown() deletes it while the context lives
+    gpuResources().shutdown();
     glfwTerminate();
-    return 0;
+
+    allocationAudit.report();
+    return allocationAudit.passed() ? 0 : 1;
 }
@@ -0,0 +1,52 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+#include "logs.h"
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char* path) {
+    close();
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error("Could not open " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    struct stat status = {};
+    if (fstat(fd, &status) != 0) {
+        error("Could not stat " << path << ": " << std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    if (status.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error("Could not map " << path << ": " << std::strerror(errno));
+        return false;
+    }
+    madvise(mapping, status.st_size, MADV_WILLNEED);
+    bytes = static_cast<const char*>(mapping);
+    length = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes)
+        munmap(const_cast<char*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
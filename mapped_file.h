@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// Read only view of a whole file. Pages are faulted in on first access, with
+// read-ahead requested for all of it, so parsing can start right away and
+// several threads can share the I/O.
+struct MappedFile {
+    public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Logs why on failure. Empty files open with a null data().
+    bool open(const char* path);
+    void close();
+
+    [[nodiscard]] const char* data() const { return bytes; }
+    [[nodiscard]] size_t size() const { return length; }
+
+    private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
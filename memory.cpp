@@ -0,0 +1,144 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "memory.h"
+
+namespace {
+
+std::atomic<uint64_t> allocationCount = 0;
+std::atomic<uint64_t> allocationBytes = 0;
+std::atomic<uint64_t> freeCount = 0;
+std::atomic<uint64_t> imguiAllocationCount = 0;
+std::atomic<uint64_t> imguiAllocationBytes = 0;
+std::atomic<uint64_t> imguiFreeCount = 0;
+// ImGui only runs on the main thread
+PoolAllocator imguiAllocator;
+// Trivially constructed, so safe to touch from operator new on any thread at any time
+thread_local HeapCounters threadCounters = {};
+
+void count(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    threadCounters.allocations++;
+    threadCounters.bytes += size;
+}
+
+void* allocate(size_t size) {
+    count(size);
+    if (size == 0)
+        size = 1;
+    return std::malloc(size);
+}
+
+void* allocateAligned(size_t size, size_t alignment) {
+    count(size);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size = (size + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, size ? size : alignment);
+}
+
+void release(void* pointer) {
+    if (!pointer)
+        return;
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    threadCounters.frees++;
+    std::free(pointer);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (auto pointer = allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (auto pointer = allocateAligned(size, static_cast<size_t>(alignment)))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { release(pointer); }
+void operator delete[](void* pointer) noexcept { release(pointer); }
+void operator delete(void* pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { release(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { release(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { release(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { release(pointer); }
+
+void* imguiAllocate(size_t size, void*) {
+    imguiAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    imguiAllocationBytes.fetch_add(size, std::memory_order_relaxed);
+    return imguiAllocator.allocate(size);
+}
+
+void imguiFree(void* pointer, void*) {
+    if (pointer)
+        imguiFreeCount.fetch_add(1, std::memory_order_relaxed);
+    imguiAllocator.free(pointer);
+}
+
+const PoolAllocator& imguiPool() {
+    return imguiAllocator;
+}
+
+HeapCounters heapCounters() {
+    return {
+        allocationCount.load(std::memory_order_relaxed),
+        allocationBytes.load(std::memory_order_relaxed),
+        freeCount.load(std::memory_order_relaxed),
+    };
+}
+
+HeapCounters threadHeapCounters() {
+    return threadCounters;
+}
+
+HeapCounters imguiHeapCounters() {
+    return {
+        imguiAllocationCount.load(std::memory_order_relaxed),
+        imguiAllocationBytes.load(std::memory_order_relaxed),
+        imguiFreeCount.load(std::memory_order_relaxed),
+    };
+}
+
+size_t residentSetSize() {
+#ifdef __linux__
+    auto file = std::fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    long pages = 0;
+    long resident = 0;
+    const int read = std::fscanf(file, "%ld %ld", &pages, &resident);
+    std::fclose(file);
+    return read == 2 ? static_cast<size_t>(resident) * sysconf(_SC_PAGESIZE) : 0;
+#else
+    // Peak rather than current, but the best portable approximation
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);
+#endif
+}
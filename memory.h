@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pool_allocator.h"
+
+// Totals since startup, counted by the global operator new/delete and the
+// ImGui allocator below. Bytes are the sizes requested, frees don't subtract.
+struct HeapCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t frees;
+};
+
+// All threads
+HeapCounters heapCounters();
+// The calling thread only
+HeapCounters threadHeapCounters();
+// Requests made by ImGui. They are served from imguiPool(), only the pool's
+// refills and large blocks show up in the other two.
+HeapCounters imguiHeapCounters();
+
+// For ImGui::SetAllocatorFunctions, which has to be called before the
+// context is created. ImGui allocates with malloc by default, many small
+// blocks per frame that are invisible to the operator new counters.
+void* imguiAllocate(size_t size, void* userData);
+void imguiFree(void* pointer, void* userData);
+const PoolAllocator& imguiPool();
+
+// Current resident set size of the process in bytes, 0 if unknown
+size_t residentSetSize();
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "mesh.h"
+#include "gl_debug.h"
+#include "logs.h"
+
+namespace {
+
+constexpr uint32_t noVertex = ~0u;
+
+uint64_t hashVertex(const vertex& v) {
+    uint32_t words[VERTEX_ELEMENT_COUNT];
+    std::memcpy(words, v, sizeof(words));
+    uint64_t hash = 0x9e3779b97f4a7c15ull;
+    for (uint32_t word : words) {
+        hash ^= word;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+size_t tableSize(size_t entries) {
+    size_t size = 16;
+    while (size < entries * 2)
+        size *= 2;
+    return size;
+}
+
+// Runs fn(0) .. fn(count - 1), fn(0) on the calling thread
+template<typename Function>
+void runParallel(int count, Function fn) {
+    std::vector<std::thread> threads;
+    threads.reserve(count - 1);
+    for (int i = 1; i < count; i++)
+        threads.emplace_back(fn, i);
+    fn(0);
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void addVertex(MeshData& mesh, float x, float y, float z, float r, float g, float b) {
+    mesh.vertices.insert(mesh.vertices.end(), {x, y, z, r, g, b});
+}
+
+} // namespace
+
+WeldStats weldVertices(MeshData& mesh, int threads) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t count = mesh.vertexCount();
+    const vertex* vertices = mesh.vertexData();
+    if (threads <= 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (count < parallelWeldVertices)
+        threads = 1;
+
+    // Each thread hashes a slice and counts how many of its vertices fall in
+    // each partition of the hash space
+    const auto partitions = static_cast<size_t>(threads);
+    std::vector<uint64_t> hashes(count);
+    std::vector<size_t> offsets(partitions * partitions); // [thread][partition]
+    runParallel(threads, [&](int thread) {
+        const size_t begin = count * thread / threads;
+        const size_t end = count * (thread + 1) / threads;
+        // Counted locally, rows of neighbouring threads share cache lines
+        std::vector<size_t> counts(partitions);
+        for (size_t i = begin; i < end; i++) {
+            hashes[i] = hashVertex(vertices[i]);
+            counts[hashes[i] % partitions]++;
+        }
+        std::copy(counts.begin(), counts.end(), offsets.begin() + thread * partitions);
+    });
+
+    // Buckets hold the vertices of one partition, slices in thread order, so
+    // scattering the slices in order leaves every bucket sorted by index
+    std::vector<size_t> bucketStart(partitions + 1);
+    size_t total = 0;
+    for (size_t partition = 0; partition < partitions; partition++) {
+        bucketStart[partition] = total;
+        for (size_t thread = 0; thread < partitions; thread++) {
+            const size_t slice = offsets[thread * partitions + partition];
+            offsets[thread * partitions + partition] = total;
+            total += slice;
+        }
+    }
+    bucketStart[partitions] = total;
+    std::vector<uint32_t> buckets(count);
+    runParallel(threads, [&](int thread) {
+        const size_t begin = count * thread / threads;
+        const size_t end = count * (thread + 1) / threads;
+        std::vector<size_t> next(offsets.begin() + thread * partitions, offsets.begin() + (thread + 1) * partitions);
+        for (size_t i = begin; i < end; i++)
+            buckets[next[hashes[i] % partitions]++] = static_cast<uint32_t>(i);
+    });
+
+    // Each thread dedupes its bucket in order, so remap points every vertex
+    // at the first identical one
+    std::vector<uint32_t> remap(count);
+    runParallel(threads, [&](int thread) {
+        const uint32_t* first = buckets.data() + bucketStart[thread];
+        const uint32_t* last = buckets.data() + bucketStart[thread + 1];
+        std::vector<uint32_t> table(tableSize(static_cast<size_t>(last - first)), noVertex);
+        const size_t mask = table.size() - 1;
+        for (; first != last; first++) {
+            const uint32_t i = *first;
+            size_t slot = (hashes[i] >> 32) & mask;
+            while (table[slot] != noVertex
+                   && (hashes[table[slot]] != hashes[i] || std::memcmp(vertices[table[slot]], vertices[i], sizeof(vertex)) != 0))
+                slot = (slot + 1) & mask;
+            if (table[slot] == noVertex)
+                table[slot] = i;
+            remap[i] = table[slot];
+        }
+    });
+
+    // First copies keep their order, everything else points at them
+    std::vector<float> welded;
+    welded.reserve(mesh.vertices.size());
+    uint32_t unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (remap[i] == i) {
+            welded.insert(welded.end(), vertices[i], vertices[i] + VERTEX_ELEMENT_COUNT);
+            remap[i] = unique++;
+        } else {
+            remap[i] = remap[remap[i]];
+        }
+    }
+
+    std::vector<uint32_t> indices(mesh.elementCount());
+    const bool soup = mesh.indices.empty();
+    runParallel(threads, [&](int thread) {
+        const size_t begin = indices.size() * thread / threads;
+        const size_t end = indices.size() * (thread + 1) / threads;
+        for (size_t i = begin; i < end; i++)
+            indices[i] = remap[soup ? i : mesh.indices[i]];
+    });
+    mesh.vertices.swap(welded);
+    mesh.indices.swap(indices);
+
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return {count, unique, threads, ms};
+}
+
+MeshData sphereSoup(int rings, int segments) {
+    MeshData mesh;
+    mesh.vertices.reserve(static_cast<size_t>(rings) * segments * 6 * VERTEX_ELEMENT_COUNT);
+    const float pi = 3.14159265f;
+    auto corner = [&](int ring, int segment) {
+        const float theta = pi * ring / rings;
+        const float phi = 2 * pi * (segment % segments) / segments;
+        const float x = std::sin(theta) * std::cos(phi);
+        const float y = std::cos(theta);
+        const float z = std::sin(theta) * std::sin(phi);
+        // Color from the normal, which is the position on a unit sphere
+        addVertex(mesh, 0.45f * x, 0.45f * y, 0.45f * z, 0.5f + 0.5f * x, 0.5f + 0.5f * y, 0.5f + 0.5f * z);
+    };
+    for (int ring = 0; ring < rings; ring++) {
+        for (int segment = 0; segment < segments; segment++) {
+            corner(ring, segment);
+            corner(ring + 1, segment);
+            corner(ring + 1, segment + 1);
+            corner(ring, segment);
+            corner(ring + 1, segment + 1);
+            corner(ring, segment + 1);
+        }
+    }
+    return mesh;
+}
+
+MeshData gridSoup(int cells) {
+    MeshData mesh;
+    mesh.vertices.reserve(static_cast<size_t>(cells) * cells * 6 * VERTEX_ELEMENT_COUNT);
+    auto corner = [&](int column, int row) {
+        const float u = static_cast<float>(column) / cells;
+        const float v = static_cast<float>(row) / cells;
+        const float height = 0.5f + 0.25f * (std::sin(u * 12.0f) + std::cos(v * 9.0f));
+        addVertex(mesh, u - 0.5f, v - 0.5f, 0.0f, height, 0.3f + 0.4f * v, 1.0f - height);
+    };
+    for (int row = 0; row < cells; row++) {
+        for (int column = 0; column < cells; column++) {
+            corner(column, row);
+            corner(column + 1, row);
+            corner(column + 1, row + 1);
+            corner(column, row);
+            corner(column + 1, row + 1);
+            corner(column, row + 1);
+        }
+    }
+    return mesh;
+}
+
+Mesh::~Mesh() {
+    destroy();
+}
+
+bool Mesh::upload(GlState& gl, GpuBufferAllocator& allocator, const MeshData& data, const char* label) {
+    MeshView view = {data.vertices.data(), data.vertexCount(), nullptr, data.indices.size(), GL_UNSIGNED_INT};
+    std::vector<uint16_t> narrow;
+    if (!data.indices.empty() && view.vertexCount <= 65536) {
+        narrow.assign(data.indices.begin(), data.indices.end());
+        view.indices = narrow.data();
+        view.indexType = GL_UNSIGNED_SHORT;
+    } else if (!data.indices.empty()) {
+        view.indices = data.indices.data();
+    }
+    return upload(gl, allocator, view, label);
+}
+
+bool Mesh::upload(GlState& gl, GpuBufferAllocator& allocator, const MeshView& view, const char* label) {
+    destroy();
+    buffers = &allocator;
+    vertexCount = view.vertexCount;
+    const size_t vertexBytes = vertexCount * sizeof(vertex);
+    vertexAllocation = buffers->allocate(gl, vertexBytes, sizeof(vertex));
+    if (!vertexAllocation) {
+        error("Could not allocate " << vertexBytes << " bytes of vertices for " << label);
+        return false;
+    }
+    buffers->upload(gl, vertexAllocation, view.vertices, vertexBytes);
+
+    if (view.indices && view.indexCount > 0) {
+        indexCount = view.indexCount;
+        indexType = view.indexType;
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        indexAllocation = buffers->allocate(gl, indexCount * indexSize, indexSize);
+        if (!indexAllocation) {
+            error("Could not allocate " << indexCount * indexSize << " bytes of indices for " << label);
+            destroy();
+            return false;
+        }
+        buffers->upload(gl, indexAllocation, view.indices, indexCount * indexSize);
+    }
+
+    // Allocations only move within their page, the buffers stay the same
+    vertexArray = gpuResources().create<GpuResourceType::VertexArray>();
+    setupVertexArray(vertexArray.id(), buffers->range(vertexAllocation).buffer);
+    if (indexAllocation)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers->range(indexAllocation).buffer);
+    labelGlObject(GL_VERTEX_ARRAY, vertexArray.id(), label);
+    gl.invalidate();
+    return true;
+}
+
+void Mesh::destroy() {
+    if (buffers) {
+        if (vertexAllocation)
+            buffers->free(vertexAllocation);
+        if (indexAllocation)
+            buffers->free(indexAllocation);
+    }
+    vertexArray.reset();
+    vertexAllocation = 0;
+    indexAllocation = 0;
+    vertexCount = 0;
+    indexCount = 0;
+}
+
+void Mesh::draw(GlState& gl, GLsizei instances) const {
+    if (!vertexArray)
+        return;
+    const auto vertices = buffers->range(vertexAllocation);
+    const auto baseVertex = static_cast<GLint>(vertices.offset / sizeof(vertex));
+    gl.bindVertexArray(vertexArray.id());
+    if (!isIndexed()) {
+        gl.drawArrays(GL_TRIANGLES, baseVertex, static_cast<GLsizei>(vertexCount), instances);
+        return;
+    }
+    const auto indices = buffers->range(indexAllocation);
+    gl.drawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), indexType, indices.offset, baseVertex, instances);
+}
+
+MeshDraw Mesh::drawCall() const {
+    if (!vertexArray)
+        return {};
+    const auto vertices = buffers->range(vertexAllocation);
+    const auto baseVertex = static_cast<GLint>(vertices.offset / sizeof(vertex));
+    if (!isIndexed())
+        return {vertices.buffer, 0, GL_UNSIGNED_INT, static_cast<GLsizei>(vertexCount), 0, baseVertex};
+    const auto indices = buffers->range(indexAllocation);
+    return {
+        vertices.buffer, indices.buffer, indexType, static_cast<GLsizei>(indexCount),
+        static_cast<GLintptr>(indices.offset), baseVertex,
+    };
+}
+
+size_t Mesh::getSize() const {
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    return vertexCount * sizeof(vertex) + indexCount * indexSize;
+}
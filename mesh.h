@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_buffer_allocator.h"
+#include "gpu_resources.h"
+#include "vertex.h"
+
+// Triangle list on the CPU, either a soup (no indices, every three vertices
+// form a triangle) or indexed.
+struct MeshData {
+    std::vector<float> vertices; // VERTEX_ELEMENT_COUNT floats per vertex, laid out like `vertex`
+    std::vector<uint32_t> indices; // Empty for a soup
+
+    [[nodiscard]] size_t vertexCount() const { return vertices.size() / VERTEX_ELEMENT_COUNT; }
+    // Indices, or vertices of a soup
+    [[nodiscard]] size_t elementCount() const { return indices.empty() ? vertexCount() : indices.size(); }
+    [[nodiscard]] const vertex* vertexData() const { return reinterpret_cast<const vertex*>(vertices.data()); }
+};
+
+// Indexed mesh data anywhere in memory, such as a mapped file, laid out as
+// it goes to GL: `vertex` records and 16 or 32 bit indices
+struct MeshView {
+    const void* vertices;
+    size_t vertexCount;
+    const void* indices; // nullptr for a soup
+    size_t indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+};
+
+struct WeldStats {
+    size_t inputVertices;
+    size_t outputVertices;
+    int threads;
+    float ms;
+};
+
+// Merges bitwise identical vertices, leaving an indexed mesh that keeps the
+// first copy of each vertex in the original order. Meshes above
+// parallelWeldVertices are hashed and deduplicated on `threads` threads
+// (0 for one per core), each owning a slice of the hash space, with the same
+// result as a single thread.
+constexpr size_t parallelWeldVertices = 1 << 16;
+WeldStats weldVertices(MeshData& mesh, int threads = 0);
+
+// Sample geometry as a loader without index support would produce it
+MeshData sphereSoup(int rings, int segments);
+MeshData gridSoup(int cells);
+
+// One draw of a mesh from its buffers, for contexts that share the buffers
+// but not the mesh's VAO. count is 0 when there is nothing to draw.
+struct MeshDraw {
+    GLuint vertexBuffer;
+    GLuint indexBuffer; // 0 for a soup
+    GLenum indexType;
+    GLsizei count; // Indices, or vertices of a soup
+    GLintptr indexOffset; // Bytes into indexBuffer
+    GLint baseVertex;
+};
+
+// Mesh on the GPU, with its vertices (and indices) in a GpuBufferAllocator.
+// Indexed meshes with up to 65536 vertices use 16 bit indices. Each mesh has
+// its own VAO pointing at the pages holding its data, and draws with a base
+// vertex, so it follows its ranges when the allocator compacts them.
+struct Mesh {
+    public:
+    Mesh() = default;
+    ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    bool upload(GlState& gl, GpuBufferAllocator& buffers, const MeshData& data, const char* label);
+    // Sends the view as it is, without a CPU side copy
+    bool upload(GlState& gl, GpuBufferAllocator& buffers, const MeshView& view, const char* label);
+    // Must run before the allocator is destroyed
+    void destroy();
+
+    void draw(GlState& gl, GLsizei instances = 1) const;
+    // The same draw, valid for this frame: compaction moves the ranges
+    [[nodiscard]] MeshDraw drawCall() const;
+
+    [[nodiscard]] bool isIndexed() const { return indexCount > 0; }
+    [[nodiscard]] size_t getVertexCount() const { return vertexCount; }
+    // Vertex and index bytes
+    [[nodiscard]] size_t getSize() const;
+
+    private:
+    GpuBufferAllocator* buffers = nullptr;
+    GpuVertexArray vertexArray;
+    uint32_t vertexAllocation = 0;
+    uint32_t indexAllocation = 0;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+};
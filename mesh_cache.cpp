@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include "mesh_cache.h"
+#include "logs.h"
+
+namespace {
+
+const char MESH_CACHE_MAGIC[8] = {'M', 'E', 'S', 'H', 'C', 'A', 'C', '\0'};
+const uint32_t MESH_CACHE_VERSION = 1;
+// Blobs start on a page so the mapping hands GL page aligned memory
+constexpr uint64_t blobAlignment = 4096;
+
+// The layout setupVertexArray() expects
+const MeshCacheAttribute vertexLayout[] = {
+    {0, 3, GL_FLOAT, 0},
+    {1, 3, GL_FLOAT, 3 * sizeof(float)},
+};
+constexpr uint32_t vertexAttributes = sizeof(vertexLayout) / sizeof(*vertexLayout);
+
+uint64_t alignUp(uint64_t value) {
+    return (value + blobAlignment - 1) / blobAlignment * blobAlignment;
+}
+
+bool sourceStamp(const char* sourcePath, uint64_t& size, int64_t& time) {
+    struct stat info = {};
+    if (stat(sourcePath, &info) != 0)
+        return false;
+    size = static_cast<uint64_t>(info.st_size);
+    time = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+bool writePadding(FILE* file, uint64_t from, uint64_t to) {
+    static const char zeros[blobAlignment] = {};
+    return to == from || std::fwrite(zeros, 1, to - from, file) == to - from;
+}
+
+} // namespace
+
+std::string meshCachePath(const char* sourcePath) {
+    return std::string(sourcePath) + ".meshcache";
+}
+
+bool writeMeshCache(const char* path, const char* sourcePath, const MeshData& mesh, const std::vector<MeshLod>& lods) {
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.headerSize = sizeof(header);
+    if (!sourceStamp(sourcePath, header.sourceSize, header.sourceTime)) {
+        warning("Could not stat " << sourcePath << ", not caching it");
+        return false;
+    }
+    header.vertexCount = static_cast<uint32_t>(mesh.vertexCount());
+    header.vertexStride = sizeof(vertex);
+    header.attributeCount = vertexAttributes;
+    std::copy(vertexLayout, vertexLayout + vertexAttributes, header.attributes);
+    header.indexSize = mesh.vertexCount() <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.indexCount = mesh.indices.size();
+    const std::vector<MeshLod> levels = lods.empty() ? std::vector<MeshLod>{{0, static_cast<uint32_t>(mesh.indices.size()), 0}} : lods;
+    header.lodCount = static_cast<uint32_t>(levels.size());
+    for (size_t v = 0; v < mesh.vertexCount(); v++) {
+        for (int axis = 0; axis < 3; axis++) {
+            const float p = mesh.vertexData()[v][axis];
+            header.boundsMin[axis] = v == 0 ? p : std::min(header.boundsMin[axis], p);
+            header.boundsMax[axis] = v == 0 ? p : std::max(header.boundsMax[axis], p);
+        }
+    }
+    const uint64_t lodEnd = sizeof(header) + levels.size() * sizeof(MeshLod);
+    const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+    const uint64_t indexBytes = header.indexCount * header.indexSize;
+    header.vertexOffset = alignUp(lodEnd);
+    header.indexOffset = alignUp(header.vertexOffset + vertexBytes);
+    header.fileSize = header.indexOffset + indexBytes;
+
+    // Written next to the target and renamed, so a crash never leaves half a cache
+    const auto temporary = std::string(path) + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        warning("Could not write mesh cache " << temporary);
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(levels.data(), sizeof(MeshLod), levels.size(), file) == levels.size();
+    ok = ok && writePadding(file, lodEnd, header.vertexOffset);
+    ok = ok && std::fwrite(mesh.vertices.data(), 1, vertexBytes, file) == vertexBytes;
+    ok = ok && writePadding(file, header.vertexOffset + vertexBytes, header.indexOffset);
+    if (header.indexSize == sizeof(uint16_t)) {
+        const std::vector<uint16_t> narrow(mesh.indices.begin(), mesh.indices.end());
+        ok = ok && std::fwrite(narrow.data(), sizeof(uint16_t), narrow.size(), file) == narrow.size();
+    } else {
+        ok = ok && std::fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file) == mesh.indices.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok || std::rename(temporary.c_str(), path) != 0) {
+        warning("Could not write mesh cache " << path);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const char* path, const char* sourcePath) {
+    close();
+    struct stat info = {};
+    if (stat(path, &info) != 0) {
+        debug("No mesh cache at " << path);
+        return false;
+    }
+    if (!file.open(path))
+        return false;
+
+    // Every offset and count is checked before anything reads through them,
+    // as differences so that huge values can't wrap around
+    auto reject = [this, path](const char* reason) {
+        warning("Ignoring mesh cache " << path << ": " << reason);
+        close();
+        return false;
+    };
+    MeshCacheHeader h = {};
+    if (file.size() < sizeof(h))
+        return reject("truncated header");
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, MESH_CACHE_MAGIC, sizeof(h.magic)) != 0 || h.version != MESH_CACHE_VERSION
+        || h.headerSize != sizeof(h))
+        return reject("unknown format or version");
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (sourcePath && (!sourceStamp(sourcePath, sourceSize, sourceTime) || sourceSize != h.sourceSize || sourceTime != h.sourceTime)) {
+        debug("Mesh cache " << path << " is older than " << sourcePath);
+        close();
+        return false;
+    }
+
+    if (h.vertexStride != sizeof(vertex) || h.attributeCount != vertexAttributes
+        || std::memcmp(h.attributes, vertexLayout, sizeof(vertexLayout)) != 0)
+        return reject("different vertex layout");
+    if (h.indexSize != (h.vertexCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t)))
+        return reject("bad index size");
+    const uint64_t vertexBytes = static_cast<uint64_t>(h.vertexCount) * h.vertexStride;
+    const uint64_t lodEnd = sizeof(h) + static_cast<uint64_t>(h.lodCount) * sizeof(MeshLod);
+    if (h.fileSize != file.size() || h.vertexOffset % blobAlignment || h.indexOffset % blobAlignment
+        || h.vertexOffset < lodEnd || h.indexOffset < h.vertexOffset || vertexBytes > h.indexOffset - h.vertexOffset
+        || h.indexOffset > h.fileSize || h.indexCount > (h.fileSize - h.indexOffset) / h.indexSize || h.indexCount % 3)
+        return reject("bad blob offsets");
+    for (uint32_t i = 0; i < h.lodCount; i++) {
+        const MeshLod& lod = lods()[i];
+        if (lod.indexCount % 3 || lod.firstIndex > h.indexCount || lod.indexCount > h.indexCount - lod.firstIndex)
+            return reject("bad level of detail");
+    }
+    // Out of range indices would have GL read past the mesh. The check reads
+    // the index blob once, which the upload needs paged in anyway.
+    const char* indices = file.data() + h.indexOffset;
+    uint32_t maxIndex = 0;
+    if (h.indexSize == sizeof(uint16_t)) {
+        auto first = reinterpret_cast<const uint16_t*>(indices);
+        maxIndex = h.indexCount > 0 ? *std::max_element(first, first + h.indexCount) : 0;
+    } else {
+        auto first = reinterpret_cast<const uint32_t*>(indices);
+        maxIndex = h.indexCount > 0 ? *std::max_element(first, first + h.indexCount) : 0;
+    }
+    if (h.indexCount > 0 && maxIndex >= h.vertexCount)
+        return reject("vertex index out of range");
+    return true;
+}
+
+void MeshCache::close() {
+    file.close();
+}
+
+const MeshLod* MeshCache::lods() const {
+    return reinterpret_cast<const MeshLod*>(file.data() + sizeof(MeshCacheHeader));
+}
+
+MeshView MeshCache::view() const {
+    const MeshCacheHeader& h = header();
+    return {
+        file.data() + h.vertexOffset, h.vertexCount,
+        h.indexCount > 0 ? file.data() + h.indexOffset : nullptr, h.indexCount,
+        static_cast<GLenum>(h.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT),
+    };
+}
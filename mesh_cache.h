@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mesh.h"
+
+// Binary form of an imported mesh, saved next to the source file so later
+// starts map it instead of parsing text. Layout, in native byte order:
+//   MeshCacheHeader, with the attribute layout of the vertices
+//   MeshLod[lodCount]
+//   vertices, page aligned, vertexStride bytes each
+//   indices, page aligned, 16 bit up to 65536 vertices and 32 bit beyond
+// so the blobs can go to GL straight from the mapping.
+
+struct MeshCacheAttribute {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type; // GL_FLOAT...
+    uint32_t offset; // Bytes into the vertex
+};
+
+// Indices of one level of detail, level 0 being the full mesh
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error; // Object space distance to level 0
+};
+
+struct MeshCacheHeader {
+    static constexpr uint32_t maxAttributes = 8;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSize;
+    int64_t sourceTime; // Modification time in ns
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t attributeCount;
+    uint32_t indexSize;
+    uint64_t indexCount;
+    uint32_t lodCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+    MeshCacheAttribute attributes[maxAttributes];
+};
+
+// Cache file for a source mesh
+std::string meshCachePath(const char* sourcePath);
+
+// Writes to a temporary file renamed into place, so readers never see half a
+// cache. Without lods the whole mesh is written as the only level.
+bool writeMeshCache(const char* path, const char* sourcePath, const MeshData& mesh, const std::vector<MeshLod>& lods = {});
+
+// A mapped cache file, checked against its source's size and modification
+// time and against the `vertex` layout. Missing, stale or malformed caches
+// fail to open (logged at debug level when missing), the caller imports the
+// source again and rewrites them.
+struct MeshCache {
+    public:
+    bool open(const char* path, const char* sourcePath);
+    void close();
+
+    [[nodiscard]] const MeshCacheHeader& header() const { return *reinterpret_cast<const MeshCacheHeader*>(file.data()); }
+    [[nodiscard]] const MeshLod* lods() const;
+    // Points into the mapping, valid until close()
+    [[nodiscard]] MeshView view() const;
+
+    private:
+    MappedFile file;
+};
@@ -0,0 +1,674 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mesh_import.h"
+#include "logs.h"
+#include "mapped_file.h"
+
+namespace {
+
+constexpr float noColor = -1.0f;
+constexpr size_t noError = ~size_t(0);
+// Binary PLY vertices converted per task
+constexpr size_t vertexBatch = 1 << 16;
+
+int threadCount(int threads) {
+    return threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+// Runs fn(0) .. fn(count - 1), claimed from a shared counter by up to `threads` threads
+template<typename Function>
+void forEachTask(size_t count, int threads, Function fn) {
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t task = next++; task < count; task = next++)
+            fn(task);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads && static_cast<size_t>(i) < count; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+}
+
+// Chunk c covers [bounds[c], bounds[c + 1]), every bound but the last at a line start
+std::vector<size_t> splitLines(const char* data, size_t size, int threads) {
+    const size_t chunks = std::max<size_t>(1, std::min(size / importChunkSize, static_cast<size_t>(threads) * 4));
+    std::vector<size_t> bounds = {0};
+    for (size_t c = 1; c < chunks; c++) {
+        const size_t from = std::max(size * c / chunks, bounds.back());
+        const void* newline = std::memchr(data + from, '\n', size - from);
+        if (!newline)
+            break;
+        const size_t at = static_cast<const char*>(newline) - data + 1;
+        if (at < size)
+            bounds.push_back(at);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+// Calls fn(begin, end) for every line in [p, end) without its line break,
+// until fn returns false
+template<typename Function>
+void forEachLine(const char* p, const char* end, Function fn) {
+    while (p < end) {
+        auto newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!newline)
+            newline = end;
+        const char* lineEnd = newline > p && newline[-1] == '\r' ? newline - 1 : newline;
+        if (!fn(p, lineEnd))
+            return;
+        p = newline + 1;
+    }
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+template<typename Number>
+bool parseNumber(const char*& p, const char* end, Number& value) {
+    p = skipSpace(p, end);
+    if (p < end && *p == '+')
+        p++;
+    const auto result = std::from_chars(p, end, value);
+    if (result.ec == std::errc::invalid_argument)
+        return false;
+    // Out of range floats are denormals or overflow, close enough to 0 either way
+    if (result.ec == std::errc::result_out_of_range)
+        value = 0;
+    p = result.ptr;
+    return true;
+}
+
+bool startsWith(const char* p, const char* end, const char* word) {
+    const size_t length = std::strlen(word);
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, word, length) == 0
+        && (static_cast<size_t>(end - p) == length || p[length] == ' ' || p[length] == '\t');
+}
+
+// First error of a chunk, by offset into the data
+struct ChunkError {
+    size_t offset = noError;
+    const char* message = nullptr;
+
+    void set(size_t at, const char* text) {
+        if (offset == noError) {
+            offset = at;
+            message = text;
+        }
+    }
+};
+
+bool reportErrors(const char* format, const char* data, const std::vector<ChunkError>& errors) {
+    for (const auto& chunkError : errors) {
+        if (chunkError.offset == noError)
+            continue;
+        const size_t line = 1 + std::count(data, data + chunkError.offset, '\n');
+        error(format << " line " << line << ": " << chunkError.message);
+        return false;
+    }
+    return true;
+}
+
+void fillMissingColors(MeshData& mesh) {
+    const size_t count = mesh.vertexCount();
+    float* v = mesh.vertices.data();
+    float low[3] = {0, 0, 0};
+    float high[3] = {0, 0, 0};
+    bool missing = false;
+    for (size_t i = 0; i < count; i++) {
+        const float* p = v + i * VERTEX_ELEMENT_COUNT;
+        for (int axis = 0; axis < 3; axis++) {
+            low[axis] = i == 0 ? p[axis] : std::min(low[axis], p[axis]);
+            high[axis] = i == 0 ? p[axis] : std::max(high[axis], p[axis]);
+        }
+        missing |= p[3] == noColor;
+    }
+    if (!missing)
+        return;
+    for (size_t i = 0; i < count; i++) {
+        float* p = v + i * VERTEX_ELEMENT_COUNT;
+        if (p[3] != noColor)
+            continue;
+        for (int axis = 0; axis < 3; axis++)
+            p[3 + axis] = high[axis] > low[axis] ? (p[axis] - low[axis]) / (high[axis] - low[axis]) : 0.5f;
+    }
+}
+
+// Concatenates per chunk index lists in chunk order
+void mergeIndices(MeshData& mesh, const std::vector<std::vector<uint32_t>>& chunks, int threads) {
+    std::vector<size_t> offsets(chunks.size() + 1, 0);
+    for (size_t c = 0; c < chunks.size(); c++)
+        offsets[c + 1] = offsets[c] + chunks[c].size();
+    mesh.indices.resize(offsets.back());
+    forEachTask(chunks.size(), threads, [&](size_t c) {
+        std::copy(chunks[c].begin(), chunks[c].end(), mesh.indices.begin() + offsets[c]);
+    });
+}
+
+// PLY
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+PlyType plyType(const std::string& name) {
+    if (name == "char" || name == "int8") return PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+    if (name == "short" || name == "int16") return PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+    if (name == "int" || name == "int32") return PlyType::Int32;
+    if (name == "uint" || name == "uint32") return PlyType::UInt32;
+    if (name == "float" || name == "float32") return PlyType::Float32;
+    if (name == "double" || name == "float64") return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+size_t plySize(PlyType type) {
+    switch (type) {
+        case PlyType::Int8: case PlyType::UInt8: return 1;
+        case PlyType::Int16: case PlyType::UInt16: return 2;
+        case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        case PlyType::Invalid: break;
+    }
+    return 0;
+}
+
+// Integer colors are scaled to 0..1
+float plyColorScale(PlyType type) {
+    switch (type) {
+        case PlyType::UInt8: return 1.0f / 255;
+        case PlyType::UInt16: return 1.0f / 65535;
+        default: return 1.0f;
+    }
+}
+
+template<typename T>
+T readRaw(const char* p, bool swap) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if (swap)
+        std::reverse(bytes, bytes + sizeof(T));
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+double readPly(const char* p, PlyType type, bool swap) {
+    switch (type) {
+        case PlyType::Int8: return readRaw<int8_t>(p, swap);
+        case PlyType::UInt8: return readRaw<uint8_t>(p, swap);
+        case PlyType::Int16: return readRaw<int16_t>(p, swap);
+        case PlyType::UInt16: return readRaw<uint16_t>(p, swap);
+        case PlyType::Int32: return readRaw<int32_t>(p, swap);
+        case PlyType::UInt32: return readRaw<uint32_t>(p, swap);
+        case PlyType::Float32: return readRaw<float>(p, swap);
+        case PlyType::Float64: return readRaw<double>(p, swap);
+        case PlyType::Invalid: break;
+    }
+    return 0;
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type; // Item type for lists
+    PlyType countType; // Invalid unless a list
+    int role; // Vertex element: 0-2 position, 3-5 color, -1 ignored. Face element: 0 for the indices.
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+    bool hasLists;
+    size_t stride; // Bytes per binary item without lists
+};
+
+enum class PlyFormat { Ascii, LittleEndian, BigEndian };
+
+struct PlyHeader {
+    PlyFormat format;
+    std::vector<PlyElement> elements;
+    int vertexElement = -1;
+    int faceElement = -1;
+    size_t bodyOffset;
+};
+
+bool parsePlyHeader(const char* data, size_t size, PlyHeader& header) {
+    const char* end = data + size;
+    bool formatSeen = false;
+    bool done = false;
+    bool valid = true;
+    size_t line = 0;
+    forEachLine(data, end, [&](const char* p, const char* lineEnd) {
+        const std::string text(p, lineEnd);
+        line++;
+        if (line == 1) {
+            valid = text == "ply";
+            return valid;
+        }
+        std::vector<std::string> words;
+        size_t at = 0;
+        while (at < text.size()) {
+            const size_t start = text.find_first_not_of(" \t", at);
+            if (start == std::string::npos)
+                break;
+            at = std::min(text.find_first_of(" \t", start), text.size());
+            words.push_back(text.substr(start, at - start));
+        }
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            return true;
+        if (words[0] == "end_header") {
+            // The last line may have no line break, leaving an empty body
+            const char* body = lineEnd;
+            if (body < end && *body == '\r')
+                body++;
+            if (body < end && *body == '\n')
+                body++;
+            header.bodyOffset = body - data;
+            done = true;
+            return false;
+        }
+        if (words[0] == "format" && words.size() >= 2) {
+            formatSeen = true;
+            if (words[1] == "ascii") header.format = PlyFormat::Ascii;
+            else if (words[1] == "binary_little_endian") header.format = PlyFormat::LittleEndian;
+            else if (words[1] == "binary_big_endian") header.format = PlyFormat::BigEndian;
+            else valid = false;
+        } else if (words[0] == "element" && words.size() == 3) {
+            PlyElement element = {words[1], std::strtoull(words[2].c_str(), nullptr, 10), {}, false, 0};
+            if (element.name == "vertex")
+                header.vertexElement = static_cast<int>(header.elements.size());
+            else if (element.name == "face")
+                header.faceElement = static_cast<int>(header.elements.size());
+            header.elements.push_back(element);
+        } else if (words[0] == "property" && !header.elements.empty()) {
+            auto& element = header.elements.back();
+            PlyProperty property = {};
+            property.role = -1;
+            property.countType = PlyType::Invalid;
+            if (words.size() == 5 && words[1] == "list") {
+                property.countType = plyType(words[2]);
+                property.type = plyType(words[3]);
+                property.name = words[4];
+                element.hasLists = true;
+                valid = property.countType != PlyType::Invalid && property.type != PlyType::Invalid;
+            } else if (words.size() == 3) {
+                property.type = plyType(words[1]);
+                property.name = words[2];
+                element.stride += plySize(property.type);
+                valid = property.type != PlyType::Invalid;
+            } else {
+                valid = false;
+            }
+            const char* roles[] = {"x", "y", "z", "red", "green", "blue"};
+            if (element.name == "vertex") {
+                for (int role = 0; role < 6; role++) {
+                    if (property.name == roles[role])
+                        property.role = role;
+                }
+            } else if (element.name == "face" && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                property.role = 0;
+            }
+            element.properties.push_back(property);
+        } else {
+            valid = false;
+        }
+        if (!valid)
+            error("Bad PLY header line " << line << ": " << text);
+        return valid;
+    });
+    if (!valid)
+        return false;
+    if (!done || !formatSeen) {
+        error("PLY header without " << (formatSeen ? "end_header" : "format"));
+        return false;
+    }
+    return true;
+}
+
+bool hasRole(const PlyElement& element, int role) {
+    return std::any_of(element.properties.begin(), element.properties.end(), [role](const auto& property) {
+        return property.role == role;
+    });
+}
+
+// Fan triangulation of one polygon, false for indices out of range
+template<typename Index>
+bool addPolygon(std::vector<uint32_t>& indices, const Index* polygon, size_t count, size_t vertexCount) {
+    for (size_t i = 0; i < count; i++) {
+        if (polygon[i] < 0 || static_cast<size_t>(polygon[i]) >= vertexCount)
+            return false;
+    }
+    for (size_t i = 2; i < count; i++) {
+        indices.push_back(static_cast<uint32_t>(polygon[0]));
+        indices.push_back(static_cast<uint32_t>(polygon[i - 1]));
+        indices.push_back(static_cast<uint32_t>(polygon[i]));
+    }
+    return true;
+}
+
+bool parsePlyAscii(const char* data, size_t size, const PlyHeader& header, MeshData& mesh, int threads) {
+    const char* body = data + header.bodyOffset;
+    const size_t bodySize = size - header.bodyOffset;
+    const size_t vertexCount = header.elements[header.vertexElement].count;
+
+    // Line ranges of the elements, then the first line of every chunk
+    std::vector<size_t> elementStart = {0};
+    for (const auto& element : header.elements)
+        elementStart.push_back(elementStart.back() + element.count);
+    const auto bounds = splitLines(body, bodySize, threads);
+    const size_t chunks = bounds.size() - 1;
+    std::vector<size_t> firstLine(chunks + 1, 0);
+    forEachTask(chunks, threads, [&](size_t c) {
+        size_t lines = 0;
+        forEachLine(body + bounds[c], body + bounds[c + 1], [&lines](const char*, const char*) {
+            lines++;
+            return true;
+        });
+        firstLine[c + 1] = lines;
+    });
+    for (size_t c = 0; c < chunks; c++)
+        firstLine[c + 1] += firstLine[c];
+    if (firstLine.back() < elementStart.back()) {
+        error("PLY body has " << firstLine.back() << " lines, the header promises " << elementStart.back());
+        return false;
+    }
+
+    mesh.vertices.assign(vertexCount * VERTEX_ELEMENT_COUNT, 0.0f);
+    const bool colors = hasRole(header.elements[header.vertexElement], 3);
+    std::vector<std::vector<uint32_t>> faces(chunks);
+    std::vector<ChunkError> errors(chunks);
+    forEachTask(chunks, threads, [&](size_t c) {
+        size_t line = firstLine[c];
+        size_t element = 0;
+        std::vector<int64_t> polygon;
+        forEachLine(body + bounds[c], body + bounds[c + 1], [&](const char* p, const char* end) {
+            const size_t lineNumber = line++;
+            while (element < header.elements.size() && lineNumber >= elementStart[element + 1])
+                element++;
+            if (element == header.elements.size())
+                return false;
+            const bool isVertex = static_cast<int>(element) == header.vertexElement;
+            const bool isFace = static_cast<int>(element) == header.faceElement;
+            if (!isVertex && !isFace)
+                return true;
+
+            float* v = isVertex ? &mesh.vertices[(lineNumber - elementStart[element]) * VERTEX_ELEMENT_COUNT] : nullptr;
+            if (isVertex && !colors)
+                v[3] = noColor;
+            for (const auto& property : header.elements[element].properties) {
+                if (property.countType == PlyType::Invalid) {
+                    double value = 0;
+                    if (!parseNumber(p, end, value)) {
+                        errors[c].set(p - data, "expected a number");
+                        return false;
+                    }
+                    if (isVertex && property.role >= 0)
+                        v[property.role] = static_cast<float>(value * (property.role >= 3 ? plyColorScale(property.type) : 1));
+                    continue;
+                }
+                size_t count = 0;
+                if (!parseNumber(p, end, count)) {
+                    errors[c].set(p - data, "expected a list length");
+                    return false;
+                }
+                // Every item takes at least a character, so longer lists can't be on the line
+                if (count > static_cast<size_t>(end - p)) {
+                    errors[c].set(p - data, "expected a list item");
+                    return false;
+                }
+                polygon.resize(count);
+                for (auto& index : polygon) {
+                    if (!parseNumber(p, end, index)) {
+                        errors[c].set(p - data, "expected a list item");
+                        return false;
+                    }
+                }
+                if (isFace && property.role == 0 && !addPolygon(faces[c], polygon.data(), count, vertexCount)) {
+                    errors[c].set(p - data, "vertex index out of range");
+                    return false;
+                }
+            }
+            return true;
+        });
+    });
+    if (!reportErrors("PLY", data, errors))
+        return false;
+    mergeIndices(mesh, faces, threads);
+    return true;
+}
+
+bool parsePlyBinary(const char* data, size_t size, const PlyHeader& header, MeshData& mesh, int threads) {
+    const bool swap = header.format == PlyFormat::BigEndian;
+    const char* p = data + header.bodyOffset;
+    const char* end = data + size;
+    const size_t vertexCount = header.elements[header.vertexElement].count;
+    auto truncated = [](const PlyElement& element) {
+        error("PLY file ends inside the " << element.name << " element");
+        return false;
+    };
+
+    for (size_t e = 0; e < header.elements.size(); e++) {
+        const auto& element = header.elements[e];
+        if (static_cast<int>(e) == header.vertexElement) {
+            if (element.hasLists) {
+                error("PLY vertices with list properties are not supported");
+                return false;
+            }
+            if (static_cast<size_t>(end - p) / std::max<size_t>(element.stride, 1) < element.count)
+                return truncated(element);
+            // Fixed size records, converted in parallel batches
+            mesh.vertices.resize(vertexCount * VERTEX_ELEMENT_COUNT);
+            const bool colors = hasRole(element, 3);
+            const char* records = p;
+            forEachTask((vertexCount + vertexBatch - 1) / vertexBatch, threads, [&](size_t batch) {
+                const size_t last = std::min(vertexCount, (batch + 1) * vertexBatch);
+                for (size_t i = batch * vertexBatch; i < last; i++) {
+                    const char* record = records + i * element.stride;
+                    float* v = &mesh.vertices[i * VERTEX_ELEMENT_COUNT];
+                    v[3] = colors ? 0.0f : noColor;
+                    for (const auto& property : element.properties) {
+                        if (property.role >= 0) {
+                            const double value = readPly(record, property.type, swap);
+                            v[property.role] = static_cast<float>(value * (property.role >= 3 ? plyColorScale(property.type) : 1));
+                        }
+                        record += plySize(property.type);
+                    }
+                }
+            });
+            p += element.count * element.stride;
+            continue;
+        }
+        if (!element.hasLists) {
+            if (static_cast<size_t>(end - p) / std::max<size_t>(element.stride, 1) < element.count)
+                return truncated(element);
+            p += element.count * element.stride;
+            continue;
+        }
+
+        // Variable sized records can only be walked in order
+        const bool isFace = static_cast<int>(e) == header.faceElement;
+        std::vector<int64_t> polygon;
+        for (size_t item = 0; item < element.count; item++) {
+            for (const auto& property : element.properties) {
+                if (property.countType == PlyType::Invalid) {
+                    if (static_cast<size_t>(end - p) < plySize(property.type))
+                        return truncated(element);
+                    p += plySize(property.type);
+                    continue;
+                }
+                const size_t countSize = plySize(property.countType);
+                if (static_cast<size_t>(end - p) < countSize)
+                    return truncated(element);
+                const auto count = static_cast<size_t>(readPly(p, property.countType, swap));
+                p += countSize;
+                const size_t itemSize = plySize(property.type);
+                if (static_cast<size_t>(end - p) / itemSize < count)
+                    return truncated(element);
+                if (isFace && property.role == 0) {
+                    polygon.resize(count);
+                    for (size_t i = 0; i < count; i++)
+                        polygon[i] = static_cast<int64_t>(readPly(p + i * itemSize, property.type, swap));
+                    if (!addPolygon(mesh.indices, polygon.data(), count, vertexCount)) {
+                        error("PLY face " << item << " has a vertex index out of range");
+                        return false;
+                    }
+                }
+                p += count * itemSize;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseObj(const char* data, size_t size, MeshData& mesh, int threads) {
+    threads = threadCount(threads);
+    const auto bounds = splitLines(data, size, threads);
+    const size_t chunks = bounds.size() - 1;
+
+    // Counting vertex lines first gives every chunk the index of its first
+    // vertex, so vertices go straight to their place and relative indices resolve
+    std::vector<size_t> firstVertex(chunks + 1, 0);
+    forEachTask(chunks, threads, [&](size_t c) {
+        size_t vertices = 0;
+        forEachLine(data + bounds[c], data + bounds[c + 1], [&vertices](const char* p, const char* end) {
+            p = skipSpace(p, end);
+            vertices += startsWith(p, end, "v");
+            return true;
+        });
+        firstVertex[c + 1] = vertices;
+    });
+    for (size_t c = 0; c < chunks; c++)
+        firstVertex[c + 1] += firstVertex[c];
+    const size_t vertexCount = firstVertex.back();
+
+    mesh.vertices.resize(vertexCount * VERTEX_ELEMENT_COUNT);
+    std::vector<std::vector<uint32_t>> faces(chunks);
+    std::vector<ChunkError> errors(chunks);
+    forEachTask(chunks, threads, [&](size_t c) {
+        size_t vertex = firstVertex[c];
+        std::vector<int64_t> polygon;
+        forEachLine(data + bounds[c], data + bounds[c + 1], [&](const char* p, const char* end) {
+            p = skipSpace(p, end);
+            if (startsWith(p, end, "v")) {
+                float* v = &mesh.vertices[vertex++ * VERTEX_ELEMENT_COUNT];
+                p++;
+                for (int i = 0; i < 3; i++) {
+                    if (!parseNumber(p, end, v[i])) {
+                        errors[c].set(p - data, "expected a vertex coordinate");
+                        return false;
+                    }
+                }
+                // Then nothing, a w to ignore or a color
+                float extra[3] = {};
+                int extras = 0;
+                while ((p = skipSpace(p, end)) < end && *p != '#') {
+                    float value = 0;
+                    if (extras == 3 || !parseNumber(p, end, value)) {
+                        errors[c].set(p - data, "expected a w or three color components");
+                        return false;
+                    }
+                    extra[extras++] = value;
+                }
+                if (extras == 2) {
+                    errors[c].set(p - data, "expected a w or three color components");
+                    return false;
+                }
+                v[3] = extras == 3 ? extra[0] : noColor;
+                v[4] = extra[1];
+                v[5] = extra[2];
+                return true;
+            }
+            if (!startsWith(p, end, "f"))
+                return true;
+
+            p++;
+            polygon.clear();
+            while ((p = skipSpace(p, end)) < end && *p != '#') {
+                int64_t index = 0;
+                if (!parseNumber(p, end, index) || index == 0) {
+                    errors[c].set(p - data, "expected a vertex index");
+                    return false;
+                }
+                // Texture coordinate and normal indices are not used
+                while (p < end && *p != ' ' && *p != '\t' && *p != '#')
+                    p++;
+                polygon.push_back(index > 0 ? index - 1 : static_cast<int64_t>(vertex) + index);
+            }
+            if (!addPolygon(faces[c], polygon.data(), polygon.size(), vertexCount)) {
+                errors[c].set(p - data, "vertex index out of range");
+                return false;
+            }
+            return true;
+        });
+    });
+    if (!reportErrors("OBJ", data, errors))
+        return false;
+    mergeIndices(mesh, faces, threads);
+    fillMissingColors(mesh);
+    return true;
+}
+
+bool parsePly(const char* data, size_t size, MeshData& mesh, int threads) {
+    threads = threadCount(threads);
+    PlyHeader header = {};
+    if (!parsePlyHeader(data, size, header))
+        return false;
+    if (header.vertexElement < 0 || !hasRole(header.elements[header.vertexElement], 0)
+        || !hasRole(header.elements[header.vertexElement], 1) || !hasRole(header.elements[header.vertexElement], 2)) {
+        error("PLY file without vertex positions");
+        return false;
+    }
+
+    mesh.indices.clear();
+    const bool parsed = header.format == PlyFormat::Ascii ? parsePlyAscii(data, size, header, mesh, threads)
+                                                          : parsePlyBinary(data, size, header, mesh, threads);
+    if (!parsed)
+        return false;
+    fillMissingColors(mesh);
+    return true;
+}
+
+bool importMesh(const char* path, MeshData& mesh, ImportStats* stats, int threads) {
+    const std::string name = path;
+    const auto extension = name.substr(std::min(name.size(), name.find_last_of('.') + 1));
+    const bool obj = extension == "obj" || extension == "OBJ";
+    if (!obj && extension != "ply" && extension != "PLY") {
+        error("Unknown mesh format: " << path);
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+    threads = threadCount(threads);
+    mesh = {};
+    const bool parsed = obj ? parseObj(file.data(), file.size(), mesh, threads)
+                            : parsePly(file.data(), file.size(), mesh, threads);
+    if (!parsed) {
+        error("Could not load " << path);
+        return false;
+    }
+    if (stats) {
+        stats->bytes = file.size();
+        stats->vertices = mesh.vertexCount();
+        stats->triangles = mesh.indices.size() / 3;
+        stats->threads = threads;
+        stats->ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mesh.h"
+
+struct ImportStats {
+    size_t bytes;
+    size_t vertices;
+    size_t triangles;
+    int threads;
+    float ms; // Parsing, the file is mapped rather than read up front
+};
+
+// Loads Wavefront OBJ and PLY meshes, picked by extension, into an indexed
+// MeshData, polygons split into triangle fans.
+// - OBJ: `v x y z [w | r g b]` and `f` lines, in any of the v, v/vt, v/vt/vn
+//   and v//vn forms, negative indices counting back, up to a `#` comment.
+//   w is ignored. Everything else is skipped.
+// - PLY: ascii, binary_little_endian and binary_big_endian with a vertex
+//   element (x, y, z, optional red, green, blue) and a face element with a
+//   vertex_indices list. Other elements and properties are skipped.
+// Vertices without a color get one from their place in the bounding box.
+//
+// Text is split at line ends into chunks of at least importChunkSize bytes,
+// parsed on `threads` threads (0 for one per core) with std::from_chars, and
+// written straight into the output. Malformed input returns false with the
+// reason logged.
+constexpr size_t importChunkSize = 1 << 20;
+bool importMesh(const char* path, MeshData& mesh, ImportStats* stats = nullptr, int threads = 0);
+bool parseObj(const char* data, size_t size, MeshData& mesh, int threads = 0);
+bool parsePly(const char* data, size_t size, MeshData& mesh, int threads = 0);
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "mesh_optimizer.h"
+
+namespace {
+
+constexpr uint32_t none = ~0u;
+
+// Scratch space of one worker, reused across chunks
+struct ChunkScratch {
+    std::vector<uint32_t> localOf; // Global vertex -> chunk vertex, none when unused
+    std::vector<uint32_t> globalOf;
+    std::vector<uint32_t> indices; // Chunk vertex ids
+    std::vector<uint32_t> adjacencyStart;
+    std::vector<uint32_t> adjacency; // Triangles using each vertex
+    std::vector<uint32_t> live; // Triangles not emitted yet per vertex
+    std::vector<uint32_t> cacheTime;
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<bool> emitted;
+    std::vector<uint32_t> order; // Triangles in emitted order
+    std::vector<uint32_t> clusterStarts; // Positions in order
+    std::vector<uint32_t> clusters;
+    std::vector<float> clusterKeys;
+};
+
+// Tipsify over scratch.indices, fills order and clusterStarts
+void tipsify(ChunkScratch& s, size_t vertexCount, int cacheSize) {
+    const size_t triangles = s.indices.size() / 3;
+    s.adjacencyStart.assign(vertexCount + 1, 0);
+    for (uint32_t index : s.indices)
+        s.adjacencyStart[index + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        s.adjacencyStart[v + 1] += s.adjacencyStart[v];
+    s.live.assign(s.adjacencyStart.begin(), s.adjacencyStart.end() - 1); // Fill cursor for now
+    s.adjacency.resize(s.indices.size());
+    for (size_t i = 0; i < s.indices.size(); i++)
+        s.adjacency[s.live[s.indices[i]]++] = static_cast<uint32_t>(i / 3);
+    for (size_t v = 0; v < vertexCount; v++)
+        s.live[v] = s.adjacencyStart[v + 1] - s.adjacencyStart[v];
+
+    const auto k = static_cast<uint32_t>(cacheSize);
+    s.cacheTime.assign(vertexCount, 0);
+    s.emitted.assign(triangles, false);
+    s.deadEnds.clear();
+    s.order.clear();
+    s.clusterStarts.clear();
+    uint32_t time = k + 1;
+    uint32_t cursor = 0;
+    uint32_t fan = triangles > 0 ? 0 : none;
+    s.clusterStarts.push_back(0);
+    while (fan != none) {
+        s.candidates.clear();
+        for (uint32_t a = s.adjacencyStart[fan]; a < s.adjacencyStart[fan + 1]; a++) {
+            const uint32_t triangle = s.adjacency[a];
+            if (s.emitted[triangle])
+                continue;
+            for (int corner = 0; corner < 3; corner++) {
+                const uint32_t v = s.indices[triangle * 3 + corner];
+                s.deadEnds.push_back(v);
+                s.candidates.push_back(v);
+                s.live[v]--;
+                if (time - s.cacheTime[v] > k)
+                    s.cacheTime[v] = time++;
+            }
+            s.emitted[triangle] = true;
+            s.order.push_back(triangle);
+        }
+
+        // Next fan: the candidate that entered the cache earliest among those
+        // whose remaining triangles still fit, else a dead end, else the next
+        // vertex with work left
+        fan = none;
+        uint32_t best = 0;
+        for (uint32_t v : s.candidates) {
+            if (s.live[v] == 0)
+                continue;
+            uint32_t priority = 0;
+            if (time - s.cacheTime[v] + 2 * s.live[v] <= k)
+                priority = time - s.cacheTime[v];
+            if (priority > best) {
+                best = priority;
+                fan = v;
+            }
+        }
+        if (fan != none)
+            continue;
+        while (!s.deadEnds.empty() && fan == none) {
+            if (s.live[s.deadEnds.back()] > 0)
+                fan = s.deadEnds.back();
+            s.deadEnds.pop_back();
+        }
+        while (fan == none && cursor < vertexCount) {
+            if (s.live[cursor] > 0)
+                fan = cursor;
+            cursor++;
+        }
+        if (fan != none)
+            s.clusterStarts.push_back(static_cast<uint32_t>(s.order.size()));
+    }
+    s.clusterStarts.push_back(static_cast<uint32_t>(s.order.size()));
+}
+
+// Sander et al.'s overdraw heuristic: clusters whose normal points away from
+// the mesh center sit on the outside and go first
+void sortClusters(ChunkScratch& s, const MeshData& mesh, const float center[3]) {
+    const size_t count = s.clusterStarts.size() - 1;
+    s.clusters.resize(count);
+    s.clusterKeys.resize(count);
+    for (size_t c = 0; c < count; c++) {
+        float normal[3] = {0, 0, 0};
+        float centroid[3] = {0, 0, 0};
+        float area = 0;
+        for (uint32_t i = s.clusterStarts[c]; i < s.clusterStarts[c + 1]; i++) {
+            const float* p[3];
+            for (int corner = 0; corner < 3; corner++)
+                p[corner] = mesh.vertexData()[s.globalOf[s.indices[s.order[i] * 3 + corner]]];
+            const float e1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+            const float e2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+            const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            const float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int axis = 0; axis < 3; axis++) {
+                normal[axis] += n[axis]; // Area weighted already
+                centroid[axis] += (p[0][axis] + p[1][axis] + p[2][axis]) / 3 * triangleArea;
+            }
+            area += triangleArea;
+        }
+        float key = 0;
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area > 0 && length > 0) {
+            for (int axis = 0; axis < 3; axis++)
+                key += (centroid[axis] / area - center[axis]) * normal[axis] / length;
+        }
+        s.clusters[c] = static_cast<uint32_t>(c);
+        s.clusterKeys[c] = key;
+    }
+    std::stable_sort(s.clusters.begin(), s.clusters.end(), [&s](uint32_t a, uint32_t b) {
+        return s.clusterKeys[a] > s.clusterKeys[b];
+    });
+}
+
+void optimizeChunk(
+    ChunkScratch& s, const MeshData& mesh, const float center[3], size_t firstTriangle, size_t triangles,
+    int cacheSize, uint32_t* output
+) {
+    const uint32_t* input = mesh.indices.data() + firstTriangle * 3;
+    s.globalOf.clear();
+    s.indices.resize(triangles * 3);
+    for (size_t i = 0; i < triangles * 3; i++) {
+        uint32_t& local = s.localOf[input[i]];
+        if (local == none) {
+            local = static_cast<uint32_t>(s.globalOf.size());
+            s.globalOf.push_back(input[i]);
+        }
+        s.indices[i] = local;
+    }
+
+    tipsify(s, s.globalOf.size(), cacheSize);
+    sortClusters(s, mesh, center);
+
+    for (uint32_t cluster : s.clusters) {
+        for (uint32_t i = s.clusterStarts[cluster]; i < s.clusterStarts[cluster + 1]; i++) {
+            for (int corner = 0; corner < 3; corner++)
+                *output++ = s.globalOf[s.indices[s.order[i] * 3 + corner]];
+        }
+    }
+    for (uint32_t global : s.globalOf)
+        s.localOf[global] = none;
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const MeshData& mesh, int cacheSize) {
+    const size_t vertexCount = mesh.vertexCount();
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    // Misses are numbered from 1, a vertex is cached while fewer than
+    // cacheSize misses followed its own
+    uint32_t misses = 0;
+    size_t usedVertices = 0;
+    for (uint32_t index : mesh.indices) {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= static_cast<uint32_t>(cacheSize))
+            insertedAt[index] = ++misses;
+        if (!used[index]) {
+            used[index] = true;
+            usedVertices++;
+        }
+    }
+    const size_t triangles = mesh.indices.size() / 3;
+    return {
+        triangles > 0 ? static_cast<float>(misses) / triangles : 0,
+        usedVertices > 0 ? static_cast<float>(misses) / usedVertices : 0,
+    };
+}
+
+MeshOptimizeStats optimizeMesh(MeshData& mesh, int threads, int cacheSize) {
+    const auto start = std::chrono::steady_clock::now();
+    MeshOptimizeStats stats = {};
+    stats.triangles = mesh.indices.size() / 3;
+    stats.before = analyzeVertexCache(mesh, cacheSize);
+
+    const size_t vertexCount = mesh.vertexCount();
+    float center[3] = {0, 0, 0};
+    for (size_t v = 0; v < vertexCount; v++) {
+        for (int axis = 0; axis < 3; axis++)
+            center[axis] += mesh.vertexData()[v][axis];
+    }
+    for (float& axis : center)
+        axis /= std::max<size_t>(vertexCount, 1);
+
+    // Chunks are claimed from a shared counter until none are left
+    const size_t chunks = (stats.triangles + optimizeChunkTriangles - 1) / optimizeChunkTriangles;
+    if (threads <= 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = static_cast<int>(std::min<size_t>(threads, std::max<size_t>(chunks, 1)));
+    std::vector<uint32_t> optimized(mesh.indices.size());
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&]() {
+        ChunkScratch scratch;
+        scratch.localOf.assign(vertexCount, none);
+        for (size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            const size_t first = chunk * optimizeChunkTriangles;
+            const size_t count = std::min(optimizeChunkTriangles, stats.triangles - first);
+            optimizeChunk(scratch, mesh, center, first, count, cacheSize, optimized.data() + first * 3);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+
+    // Vertices in first use order, unused ones at the end
+    std::vector<uint32_t> remap(vertexCount, none);
+    std::vector<float> vertices(mesh.vertices.size());
+    uint32_t next = 0;
+    auto place = [&](uint32_t v) {
+        remap[v] = next;
+        std::copy_n(mesh.vertexData()[v], VERTEX_ELEMENT_COUNT, &vertices[static_cast<size_t>(next) * VERTEX_ELEMENT_COUNT]);
+        next++;
+    };
+    for (uint32_t& index : optimized) {
+        if (remap[index] == none)
+            place(index);
+        index = remap[index];
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == none)
+            place(static_cast<uint32_t>(v));
+    }
+    mesh.vertices.swap(vertices);
+    mesh.indices.swap(optimized);
+
+    stats.after = analyzeVertexCache(mesh, cacheSize);
+    stats.threads = threads;
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
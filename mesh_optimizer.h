@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.h"
+
+// Transformed vertices per triangle (ACMR) and per vertex (ATVR) through a
+// FIFO post-transform cache of `cacheSize` entries. Lower is better, the
+// ideal ATVR is 1.
+struct VertexCacheStats {
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const MeshData& mesh, int cacheSize = 16);
+
+struct MeshOptimizeStats {
+    size_t triangles;
+    VertexCacheStats before;
+    VertexCacheStats after;
+    int threads;
+    float ms;
+};
+
+// Reorders an indexed mesh for drawing, in three steps:
+// - triangles with Tipsify (Sander et al. 2007) for the vertex cache, which
+//   also splits them into clusters wherever it has to jump to a new area
+// - clusters facing away from the mesh center first, so outer surfaces tend
+//   to be drawn before what they hide (less overdraw)
+// - vertices in the order triangles first use them, for vertex fetch
+// Large meshes are processed in chunks of optimizeChunkTriangles on `threads`
+// threads (0 for one per core); chunks are fixed, so the result does not
+// depend on the thread count.
+constexpr size_t optimizeChunkTriangles = 1 << 16;
+MeshOptimizeStats optimizeMesh(MeshData& mesh, int threads = 0, int cacheSize = 16);
@@ -0,0 +1,87 @@
+#include <string>
+
+#include "output_window.h"
+#include "gl_debug.h"
+#include "logs.h"
+#include "stats.h"
+#include "vertex.h"
+
+OutputWindow::~OutputWindow() {
+    destroy();
+}
+
+bool OutputWindow::init(GLFWwindow* shared, int index, int width, int height) {
+    const auto title = "Output " + std::to_string(index);
+    // Inherits the context hints given for the main window
+    window = glfwCreateWindow(width, height, title.c_str(), nullptr, shared);
+    if (!window) {
+        error("Could not open output window " << index);
+        return false;
+    }
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int, int action, int) {
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+            glfwSetWindowShouldClose(w, GLFW_TRUE);
+    });
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    installGlDebugOutput(GL_DEBUG_SEVERITY_LOW);
+
+    // VAOs are not shared, so this one stays out of the main context's registry
+    glGenVertexArrays(1, &vertexArray);
+    labelGlObject(GL_VERTEX_ARRAY, vertexArray, title.c_str());
+    return true;
+}
+
+void OutputWindow::destroy() {
+    if (!window)
+        return;
+    glfwMakeContextCurrent(window);
+    glDeleteVertexArrays(1, &vertexArray);
+    vertexArray = 0;
+    glfwMakeContextCurrent(nullptr);
+    glfwDestroyWindow(window);
+    window = nullptr;
+}
+
+void OutputWindow::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
+    auto output = static_cast<OutputWindow*>(glfwGetWindowUserPointer(window));
+    output->framebufferWidth = width;
+    output->framebufferHeight = height;
+    output->framebufferResized = true;
+}
+
+void OutputWindow::render(GLuint program, const MeshDraw& scene, GLsizei instances, GLsync uploaded) {
+    glfwMakeContextCurrent(window);
+    if (framebufferResized) {
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        framebufferResized = false;
+    }
+
+    // Changes to a shared object only become visible to this context after
+    // the writer's fence and a rebind here
+    if (uploaded)
+        glWaitSync(uploaded, 0, GL_TIMEOUT_IGNORED);
+
+    glClearColor(0, 0, 0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (scene.count > 0) {
+        // Mesh buffers change with the scene, eviction and compaction, and a
+        // deleted name may come back for another buffer, so the VAO is pointed
+        // at the current ones every frame. That is also the rebind.
+        setupVertexArray(vertexArray, scene.vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.indexBuffer);
+        gl.invalidate();
+        gl.useProgram(program);
+        gl.bindVertexArray(vertexArray);
+        if (scene.indexBuffer)
+            gl.drawElements(GL_TRIANGLES, scene.count, scene.indexType, scene.indexOffset, scene.baseVertex, instances);
+        else
+            gl.drawArrays(GL_TRIANGLES, scene.baseVertex, scene.count, instances);
+    }
+    glfwSwapBuffers(window);
+    frameCounters().outputWindows++;
+}
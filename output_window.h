@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_state.h"
+#include "mesh.h"
+
+// Extra window showing the scene, drawn from the buffers the main window used. Its context shares objects with the main
+// one, so programs and buffers exist once. Container objects (VAOs and
+// framebuffers) are not shared between contexts and bindings are per context,
+// so every window has its own VAO and its own GlState.
+//
+// All windows are rendered from the main thread, one after the other: every
+// output costs a context switch, a few draws and a swap, which never waits
+// for vsync so outputs cannot stall each other.
+struct OutputWindow {
+    public:
+    OutputWindow() = default;
+    ~OutputWindow();
+    OutputWindow(const OutputWindow&) = delete;
+    OutputWindow& operator=(const OutputWindow&) = delete;
+
+    // Leaves the new window's context current
+    bool init(GLFWwindow* shared, int index, int width, int height);
+    // Leaves no context current
+    void destroy();
+    // False once the user closed the window
+    [[nodiscard]] bool isOpen() const { return window && !glfwWindowShouldClose(window); }
+
+    // Renders `scene`, the main window's draw this frame, into this window and
+    // presents it, leaving its context current. `uploaded` is a fence after
+    // the latest buffer writes in the main context, or nullptr when nothing changed.
+    void render(GLuint program, const MeshDraw& scene, GLsizei instances, GLsync uploaded);
+
+    private:
+    static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+
+    GLFWwindow* window = nullptr;
+    GlState gl;
+    GLuint vertexArray = 0;
+    int framebufferWidth = 0;
+    int framebufferHeight = 0;
+    bool framebufferResized = true;
+};
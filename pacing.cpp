@@ -0,0 +1,28 @@
+#include <algorithm>
+
+#include "pacing.h"
+
+void FramePacer::recordWork(float ms) {
+    // Jumps up at once and decays slowly, a missed vblank costs a whole refresh
+    workEstimateMs = std::max(ms, workEstimateMs * 0.95f + ms * 0.05f);
+}
+
+FramePacer::Clock::time_point FramePacer::nextFrameStart(
+    Clock::time_point frameStart, Clock::time_point presented,
+    int frameCap, bool justInTime, double refreshRate, float marginMs
+) const {
+    using std::chrono::duration;
+    using std::chrono::duration_cast;
+
+    auto next = frameStart;
+    if (frameCap > 0)
+        next += duration_cast<Clock::duration>(duration<double>(1.0 / frameCap));
+
+    if (justInTime && refreshRate > 0) {
+        const double periodMs = 1000.0 / refreshRate;
+        // Work longer than a refresh just starts right away
+        const double delayMs = std::max(periodMs - workEstimateMs - marginMs, 0.0);
+        next = std::max(next, presented + duration_cast<Clock::duration>(duration<double, std::milli>(delayMs)));
+    }
+    return next;
+}
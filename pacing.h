@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+// Decides when the next frame starts. Either as soon as the frame cap allows,
+// or "just in time": as late as possible before the next vertical blank, so
+// input is sampled right before the frame that shows it instead of one
+// refresh earlier. The latter needs vsync and a swap that returns at the
+// vblank, which the caller gets by calling glFinish after glfwSwapBuffers.
+struct FramePacer {
+    public:
+    using Clock = std::chrono::steady_clock;
+
+    // CPU time from sampling input until the swap call
+    void recordWork(float ms);
+    [[nodiscard]] float getWorkEstimateMs() const { return workEstimateMs; }
+
+    // frameCap 0 means no cap, refreshRate is in Hz and only used just in time
+    [[nodiscard]] Clock::time_point nextFrameStart(
+        Clock::time_point frameStart, Clock::time_point presented,
+        int frameCap, bool justInTime, double refreshRate, float marginMs
+    ) const;
+
+    private:
+    float workEstimateMs = 0;
+};
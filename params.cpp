@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+
+#include <imgui.h>
+
+#include "params.h"
+#include "logs.h"
+
+namespace {
+
+const int64_t startTime = Trace::now();
+
+std::string trim(const std::string& text) {
+    const auto begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return "";
+    const auto end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+void ParamRegistry::add(
+    const char* name, const char* description, Type type, void* value,
+    float min, float max, std::vector<const char*> options
+) {
+    auto eventName = std::string("param.") + name;
+    entries.push_back({
+        name, description, type, value, min, max, std::move(options),
+        TraceEvent<uint32_t, double>(eventName.c_str(), {"frame", "value"}),
+    });
+}
+
+void ParamRegistry::addInt(const char* name, const char* description, int* value, int min, int max) {
+    add(name, description, Int, value, static_cast<float>(min), static_cast<float>(max));
+}
+
+void ParamRegistry::addFloat(const char* name, const char* description, float* value, float min, float max) {
+    add(name, description, Float, value, min, max);
+}
+
+void ParamRegistry::addBool(const char* name, const char* description, bool* value) {
+    add(name, description, Bool, value, 0, 1);
+}
+
+void ParamRegistry::addEnum(const char* name, const char* description, int* value, std::vector<const char*> options) {
+    const float max = static_cast<float>(options.size()) - 1;
+    add(name, description, Enum, value, 0, max, std::move(options));
+}
+
+void ParamRegistry::addString(const char* name, const char* description, std::string* value) {
+    add(name, description, String, value, 0, 0);
+}
+
+void ParamRegistry::setStartupOnly(const char* name) {
+    if (auto entry = find(name))
+        entry->startupOnly = true;
+}
+
+ParamRegistry::Entry* ParamRegistry::find(const std::string& name) {
+    for (auto& entry : entries) {
+        if (name == entry.name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+std::string ParamRegistry::format(const Entry& entry) const {
+    switch (entry.type) {
+        case Int: return std::to_string(*static_cast<int*>(entry.value));
+        case Float: return std::to_string(*static_cast<float*>(entry.value));
+        case Bool: return *static_cast<bool*>(entry.value) ? "true" : "false";
+        case Enum: return entry.options[*static_cast<int*>(entry.value)];
+        case String: return *static_cast<std::string*>(entry.value);
+    }
+    return "";
+}
+
+bool ParamRegistry::set(const std::string& name, const std::string& text) {
+    auto entry = find(name);
+    if (!entry) {
+        error("Unknown parameter " << name);
+        return false;
+    }
+
+    char* end = nullptr;
+    switch (entry->type) {
+        case Int: {
+            long value = std::strtol(text.c_str(), &end, 10);
+            if (end == text.c_str() || *end || value < entry->min || value > entry->max)
+                break;
+            *static_cast<int*>(entry->value) = static_cast<int>(value);
+            changed(*entry);
+            return true;
+        }
+        case Float: {
+            float value = std::strtof(text.c_str(), &end);
+            // Written so that NaN fails the range check
+            if (end == text.c_str() || *end || !(value >= entry->min && value <= entry->max))
+                break;
+            *static_cast<float*>(entry->value) = value;
+            changed(*entry);
+            return true;
+        }
+        case Bool: {
+            if (text != "true" && text != "false" && text != "1" && text != "0")
+                break;
+            *static_cast<bool*>(entry->value) = text == "true" || text == "1";
+            changed(*entry);
+            return true;
+        }
+        case Enum: {
+            for (size_t i = 0; i < entry->options.size(); i++) {
+                if (text == entry->options[i]) {
+                    *static_cast<int*>(entry->value) = static_cast<int>(i);
+                    changed(*entry);
+                    return true;
+                }
+            }
+            break;
+        }
+        case String: {
+            *static_cast<std::string*>(entry->value) = text;
+            changed(*entry);
+            return true;
+        }
+    }
+
+    error("Invalid value for " << name << ": " << text);
+    return false;
+}
+
+bool ParamRegistry::parseArguments(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            error("Unexpected argument " << argument);
+            return false;
+        }
+        argument = argument.substr(2);
+
+        std::string name = argument;
+        std::string value;
+        auto equals = argument.find('=');
+        if (equals != std::string::npos) {
+            name = argument.substr(0, equals);
+            value = argument.substr(equals + 1);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            error("Missing value for --" << name);
+            return false;
+        }
+
+        const bool ok = name == "config" ? loadFile(value.c_str()) : set(name, value);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool ParamRegistry::loadFile(const char* path) {
+    auto stream = std::ifstream(path);
+    if (!stream) {
+        error("Could not open config file " << path);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        auto equals = line.find('=');
+        if (equals == std::string::npos) {
+            error(path << ":" << lineNumber << ": expected name = value");
+            return false;
+        }
+        if (!set(trim(line.substr(0, equals)), trim(line.substr(equals + 1))))
+            return false;
+    }
+    return true;
+}
+
+void ParamRegistry::printUsage(const char* program) const {
+    std::cout << "Usage: " << program << " [--config FILE] [--NAME=VALUE]...\n\n";
+    for (auto& entry : entries) {
+        std::cout << "  --" << entry.name << " (" << format(entry) << ")  " << entry.description;
+        if (entry.type == Int || entry.type == Float)
+            std::cout << " [" << entry.min << ", " << entry.max << "]";
+        if (entry.type == Enum) {
+            std::cout << " [";
+            for (size_t i = 0; i < entry.options.size(); i++)
+                std::cout << (i ? "|" : "") << entry.options[i];
+            std::cout << "]";
+        }
+        std::cout << "\n";
+    }
+}
+
+void ParamRegistry::changed(const Entry& entry) {
+    double value = 0;
+    switch (entry.type) {
+        case Int: case Enum: value = *static_cast<int*>(entry.value); break;
+        case Float: value = *static_cast<float*>(entry.value); break;
+        case Bool: value = *static_cast<bool*>(entry.value); break;
+        case String: break; // Only the log has the text
+    }
+    entry.event(currentFrame, value);
+
+    const double seconds = (Trace::now() - startTime) / 1e9;
+    info("t=" << seconds << "s frame " << currentFrame << ": " << entry.name << " = " << format(entry));
+}
+
+void ParamRegistry::drawPanel(bool* open) {
+    if (!*open)
+        return;
+
+    ImGui::SetNextWindowPos(ImVec2(400, 10), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Tuning", open, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::End();
+        return;
+    }
+
+    for (auto& entry : entries) {
+        if (entry.startupOnly) {
+            ImGui::TextDisabled("%s: %s", entry.name, format(entry).c_str());
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("%s", entry.description);
+            continue;
+        }
+        bool edited = false;
+        switch (entry.type) {
+            case Int:
+                edited = ImGui::SliderInt(
+                    entry.name, static_cast<int*>(entry.value),
+                    static_cast<int>(entry.min), static_cast<int>(entry.max),
+                    "%d", ImGuiSliderFlags_AlwaysClamp
+                );
+                break;
+            case Float:
+                edited = ImGui::SliderFloat(
+                    entry.name, static_cast<float*>(entry.value), entry.min, entry.max,
+                    "%.3f", ImGuiSliderFlags_AlwaysClamp
+                );
+                break;
+            case Bool:
+                edited = ImGui::Checkbox(entry.name, static_cast<bool*>(entry.value));
+                break;
+            case Enum:
+                edited = ImGui::Combo(
+                    entry.name, static_cast<int*>(entry.value),
+                    entry.options.data(), static_cast<int>(entry.options.size())
+                );
+                break;
+            case String:
+                ImGui::Text("%s: %s", entry.name, static_cast<std::string*>(entry.value)->c_str());
+                break;
+        }
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("%s", entry.description);
+        if (edited)
+            changed(entry);
+    }
+
+    ImGui::End();
+}
+
+void registerParams(ParamRegistry& registry, Params& params) {
+    registry.addInt("frame-cap", "Target frames per second, 0 for uncapped", &params.frameCap, 0, 1000);
+    registry.addEnum("present", "Vsync mode", &params.presentMode, {"off", "on", "adaptive"});
+    registry.addBool("just-in-time", "Sample input right before the expected vblank, needs vsync", &params.justInTime);
+    registry.addFloat("jit-margin", "Slack in ms kept before the vblank in just in time mode", &params.justInTimeMargin, 0, 16);
+    registry.addInt("instances", "Number of triangle instances drawn", &params.instanceCount, 1, 10000);
+    registry.addEnum(
+        "upload", "How vertex data reaches the GPU", &params.uploadStrategy,
+        {"buffer-data", "buffer-sub-data", "orphan", "map-range", "staged"}
+    );
+    registry.addEnum(
+        "animation", "Triangle animation", &params.animationMode,
+        {"static", "per-frame", "per-second"}
+    );
+    registry.addEnum("mesh", "What the scene draws", &params.sceneMesh, {"triangle", "sphere", "grid", "file"});
+    registry.addString("mesh-file", "OBJ or PLY file drawn with --mesh file, read at startup", &params.meshFile);
+    registry.addBool("mesh-cache", "Keep a binary copy of --mesh-file next to it and load that when up to date", &params.meshCache);
+    registry.addBool("indexed", "Draw sample meshes welded and indexed rather than as triangle soups", &params.indexed);
+    registry.addInt("width", "Window width", &params.windowWidth, 100, 4096);
+    registry.addInt("height", "Window height", &params.windowHeight, 100, 4096);
+    registry.addInt("outputs", "Extra windows sharing the scene's GL objects", &params.outputCount, 0, 16);
+    registry.addEnum("ui", "How the UI is rendered", &params.uiMode, {"direct", "cached"});
+    registry.addEnum("ui-renderer", "Which backend draws ImGui", &params.uiRenderer, {"stock", "streaming"});
+    registry.addBool("idle", "Render only on input or while animating, block for events otherwise", &params.idle);
+    registry.addInt("idle-timeout", "Longest wait for events in idle mode in ms, 0 for no limit", &params.idleTimeout, 0, 10000);
+    registry.addInt("frame-arena", "Scratch memory per frame in flight in KiB, read at startup", &params.frameArenaSize, 4, 65536);
+    registry.addBool("huge-pages", "Back the frame arena with huge pages, read at startup", &params.hugePages);
+    registry.addInt("compact-budget", "KiB of mesh buffer data moved per frame to undo fragmentation, 0 disables", &params.compactBudget, 0, 65536);
+    registry.addInt("gpu-budget", "MiB of GPU memory before streamed buffers are evicted, 0 for no limit", &params.gpuBudget, 0, 65536);
+    registry.addInt("upload-budget", "KiB of non urgent staged updates sent per frame, 0 for no limit", &params.uploadBudget, 0, 1 << 20);
+    registry.addInt("stream-rate", "MiB of streamed buffers loaded per frame", &params.streamRate, 1, 1024);
+    registry.addBool("stream-meshes", "Draw indexed meshes from buffers --gpu-budget may evict, read at startup", &params.streamMeshes);
+    registry.addBool("headless", "Keep the window hidden, read at startup", &params.headless);
+    registry.addInt("frames", "Exit after this many frames, 0 for no limit", &params.frameLimit, 0, 100000000);
+    registry.addInt(
+        "alloc-budget", "Heap allocations allowed per frame after the warmup, exits with 1 when exceeded, -1 for no check",
+        &params.allocationBudget, -1, 100000
+    );
+    registry.addInt("alloc-warmup", "Frames that may allocate freely before alloc-budget applies", &params.allocationWarmup, 0, 100000);
+    registry.addInt("ui-rate", "Cached UI refreshes per second without input, 0 for input only", &params.uiRefreshRate, 0, 240);
+
+    // Changing these after startup would do nothing
+    for (const char* name : {"mesh-file", "frame-arena", "huge-pages", "headless", "stream-meshes"})
+        registry.setStartupOnly(name);
+}
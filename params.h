@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// Runtime knobs. Everything here may change at any frame, either from the
+// tuning panel or from the command line / config file at startup.
+struct Params {
+    enum UploadStrategy {
+        BufferData,    // Respecify the whole buffer
+        BufferSubData, // Overwrite in place
+        Orphan,        // glBufferData(nullptr) followed by glBufferSubData
+        MapRange,      // glMapBufferRange with GL_MAP_INVALIDATE_BUFFER_BIT
+        Staged,        // Batched with the frame's other updates by the UploadManager
+    };
+
+    enum AnimationMode {
+        Static,
+        PerFrame, // Advances a fixed step every frame
+        PerSecond, // Advances with wall clock time
+    };
+
+    enum SceneMesh {
+        MeshTriangle, // The animated triangle
+        MeshSphere,
+        MeshGrid,
+        MeshFile, // Imported from meshFile
+    };
+
+    enum PresentMode {
+        PresentOff,      // Swap interval 0, tears
+        PresentOn,       // Swap interval 1
+        PresentAdaptive, // Swap interval -1, tears only when a vblank was missed
+    };
+
+    enum UiMode {
+        UiDirect, // Build and render the UI every frame
+        UiCached, // Render into a texture only on input or at uiRefreshRate
+    };
+
+    enum UiRenderer {
+        UiStock,     // imgui_impl_opengl3
+        UiStreaming, // ImGuiRenderer, one persistently mapped ring for all draw lists
+    };
+
+    int frameCap = 60; // 0 means uncapped
+    int presentMode = PresentOff;
+    bool justInTime = false; // Start frames as late as possible before the vblank
+    float justInTimeMargin = 2.0f; // ms of slack on top of the estimated frame work
+    int instanceCount = 1;
+    int uploadStrategy = BufferData;
+    int animationMode = PerFrame;
+    int sceneMesh = MeshTriangle;
+    std::string meshFile; // OBJ or PLY file for MeshFile, only read at startup
+    bool meshCache = true; // Load meshFile from, and save it to, a binary cache next to it
+    bool indexed = true; // Draw sample meshes welded and indexed instead of as loaded
+    int windowWidth = 800;
+    int windowHeight = 800;
+    int outputCount = 0; // Extra windows showing the scene
+    int uiMode = UiDirect;
+    int uiRefreshRate = 10; // Hz, 0 redraws on input only
+    int uiRenderer = UiStreaming;
+    bool idle = false; // Only render after input or while animating
+    int idleTimeout = 250; // ms to block for events in idle mode, 0 blocks until one arrives
+    int frameArenaSize = 256; // KiB per frame in flight, only read at startup
+    bool hugePages = false; // Back the frame arena with huge pages, only read at startup
+    int compactBudget = 256; // KiB of mesh data moved per frame to defragment, 0 disables
+    int gpuBudget = 0; // MiB of tracked GPU memory before streamed buffers are evicted, 0 for no limit
+    int streamRate = 8; // MiB of streamed buffers loaded per frame
+    bool streamMeshes = false; // Indexed meshes in buffers the residency manager may evict, only read at startup
+    int uploadBudget = 1024; // KiB of non urgent staged updates per frame, 0 for no limit
+    bool headless = false; // Hidden window, only read at startup
+    int frameLimit = 0; // Exit after this many frames, 0 runs until the window closes
+    int allocationBudget = -1; // Heap allocations allowed per frame after the warmup, -1 to not check
+    int allocationWarmup = 300; // Frames before the budget applies
+};
+
+// Typed view of a set of variables, used for parsing and for the tuning panel.
+// Every change is logged and traced with a timestamp so it can be matched to
+// frame statistics.
+struct ParamRegistry {
+    public:
+    enum Type {
+        Int,
+        Float,
+        Bool,
+        Enum,
+        String,
+    };
+
+    struct Entry {
+        const char* name;
+        const char* description;
+        Type type;
+        void* value;
+        float min;
+        float max;
+        std::vector<const char*> options;
+        TraceEvent<uint32_t, double> event; // param.<name> with the frame and new value
+        bool startupOnly = false;
+    };
+
+    void addInt(const char* name, const char* description, int* value, int min, int max);
+    void addFloat(const char* name, const char* description, float* value, float min, float max);
+    void addBool(const char* name, const char* description, bool* value);
+    // Enum values are stored as ints, options are the names of 0, 1, 2...
+    void addEnum(const char* name, const char* description, int* value, std::vector<const char*> options);
+    // Shown but not editable in the panel
+    void addString(const char* name, const char* description, std::string* value);
+    // For values only read at startup: settable from the command line and
+    // config files, shown read-only in the panel
+    void setStartupOnly(const char* name);
+
+    // Parses and range checks the value, returns false for unknown names or bad values
+    bool set(const std::string& name, const std::string& text);
+    // Accepts --name=value, --name value and --config path (loaded in place)
+    bool parseArguments(int argc, char** argv);
+    // Lines of `name = value`, # starts a comment
+    bool loadFile(const char* path);
+    void printUsage(const char* program) const;
+
+    // Frame index that changes are attributed to
+    void setFrame(uint32_t frame) { currentFrame = frame; }
+    void drawPanel(bool* open);
+
+    private:
+    Entry* find(const std::string& name);
+    void add(const char* name, const char* description, Type type, void* value, float min, float max, std::vector<const char*> options = {});
+    void changed(const Entry& entry);
+    [[nodiscard]] std::string format(const Entry& entry) const;
+
+    std::vector<Entry> entries;
+    uint32_t currentFrame = 0;
+};
+
+// Registers every field of params
+void registerParams(ParamRegistry& registry, Params& params);
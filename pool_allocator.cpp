@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <new>
+
+#include "pool_allocator.h"
+
+namespace {
+
+// Steps of 16 up to 128, then four classes per power of two
+constexpr uint32_t classSizes[] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096,
+};
+static_assert(sizeof(classSizes) / sizeof(*classSizes) == PoolAllocator::classCount);
+static_assert(classSizes[PoolAllocator::classCount - 1] == PoolAllocator::maxPooledSize);
+
+} // namespace
+
+PoolAllocator::PoolAllocator() {
+    for (size_t i = 0; i < classCount; i++)
+        classes[i] = {classSizes[i], 0, 0, 0};
+}
+
+PoolAllocator::~PoolAllocator() {
+    for (void* chunk : chunks)
+        operator delete(chunk);
+}
+
+size_t PoolAllocator::classIndex(size_t size) {
+    if (size <= 128)
+        return size == 0 ? 0 : (size - 1) / 16;
+    return std::lower_bound(classSizes + 8, classSizes + classCount, size) - classSizes;
+}
+
+void PoolAllocator::refill(size_t index) {
+    const size_t stride = sizeof(Header) + classSizes[index];
+    const size_t blocks = chunkSize / stride;
+    auto chunk = static_cast<char*>(operator new(chunkSize));
+    chunks.push_back(chunk);
+    // Pushed in reverse so blocks come out in address order
+    for (size_t i = blocks; i-- > 0;) {
+        auto block = reinterpret_cast<FreeBlock*>(chunk + i * stride + sizeof(Header));
+        block->next = freeLists[index];
+        freeLists[index] = block;
+    }
+    classes[index].blocksFree += static_cast<uint32_t>(blocks);
+}
+
+void* PoolAllocator::allocate(size_t size) {
+    inUse += size;
+    if (size > maxPooledSize) {
+        auto header = static_cast<Header*>(operator new(sizeof(Header) + size));
+        *header = {size, classCount, 0};
+        largeInUse += sizeof(Header) + size;
+        largeCount++;
+        return header + 1;
+    }
+
+    const size_t index = classIndex(size);
+    if (!freeLists[index])
+        refill(index);
+    FreeBlock* block = freeLists[index];
+    freeLists[index] = block->next;
+
+    auto& sizeClass = classes[index];
+    sizeClass.blocksFree--;
+    sizeClass.blocksInUse++;
+    sizeClass.allocations++;
+    auto header = reinterpret_cast<Header*>(block) - 1;
+    *header = {size, static_cast<uint32_t>(index), 0};
+    return block;
+}
+
+void PoolAllocator::free(void* pointer) {
+    if (!pointer)
+        return;
+    auto header = static_cast<Header*>(pointer) - 1;
+    inUse -= header->size;
+    if (header->sizeClass == classCount) {
+        largeInUse -= sizeof(Header) + header->size;
+        operator delete(header);
+        return;
+    }
+
+    const size_t index = header->sizeClass;
+    auto block = static_cast<FreeBlock*>(pointer);
+    block->next = freeLists[index];
+    freeLists[index] = block;
+    classes[index].blocksInUse--;
+    classes[index].blocksFree++;
+}
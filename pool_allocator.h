@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Size class allocator for many small, short-lived blocks. Every class keeps
+// a free list of blocks carved out of 64 KiB chunks. Freed blocks go back on
+// their list and chunks are kept until destruction, so memory grows to the
+// peak working set and stays there instead of fragmenting the heap over a
+// long session. Sizes above maxPooledSize go straight to operator new.
+//
+// A 16 byte header in front of every block records its class, so free()
+// needs no size. Blocks are 16 byte aligned. Not thread safe.
+struct PoolAllocator {
+    public:
+    static constexpr size_t chunkSize = 64 * 1024;
+    static constexpr size_t maxPooledSize = 4096;
+    static constexpr size_t classCount = 28;
+
+    struct SizeClass {
+        uint32_t blockSize; // Largest request served, without the header
+        uint32_t blocksInUse;
+        uint32_t blocksFree;
+        uint64_t allocations; // Since startup
+    };
+
+    PoolAllocator();
+    ~PoolAllocator();
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* allocate(size_t size);
+    void free(void* pointer);
+
+    [[nodiscard]] const SizeClass& sizeClass(size_t index) const { return classes[index]; }
+    // Bytes handed out and not freed yet, as requested
+    [[nodiscard]] size_t bytesInUse() const { return inUse; }
+    // Chunks plus live large blocks, what the pool takes from the heap
+    [[nodiscard]] size_t bytesReserved() const { return chunks.size() * chunkSize + largeInUse; }
+    [[nodiscard]] uint64_t largeAllocations() const { return largeCount; }
+
+    private:
+    struct Header {
+        uint64_t size;
+        uint32_t sizeClass; // classCount for large blocks
+        uint32_t padding;
+    };
+    static_assert(sizeof(Header) == 16);
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static size_t classIndex(size_t size);
+    void refill(size_t index);
+
+    SizeClass classes[classCount];
+    FreeBlock* freeLists[classCount] = {};
+    std::vector<void*> chunks;
+    size_t inUse = 0;
+    size_t largeInUse = 0;
+    uint64_t largeCount = 0;
+};
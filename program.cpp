@@ -1,18 +1,45 @@
+#include <utility>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "program.h"
+#include "gl_debug.h"
 #include "logs.h"
 
 Program::Program() {}
 
 Program::~Program() {
+    destroy();
+}
+
+Program::Program(Program&& other) noexcept
+    : program(std::move(other.program)),
+      fragmentShader(std::exchange(other.fragmentShader, std::nullopt)),
+      vertexShader(std::exchange(other.vertexShader, std::nullopt)) {}
+
+Program& Program::operator=(Program&& other) noexcept {
+    if (this != &other) {
+        deleteShaders();
+        program = std::move(other.program);
+        fragmentShader = std::exchange(other.fragmentShader, std::nullopt);
+        vertexShader = std::exchange(other.vertexShader, std::nullopt);
+    }
+    return *this;
+}
+
+void Program::destroy() {
+    deleteShaders();
+    program.reset();
+}
+
+void Program::deleteShaders() {
     if (fragmentShader.has_value())
         glDeleteShader(fragmentShader.value());
     if (vertexShader.has_value())
         glDeleteShader(vertexShader.value());
-    if (id.has_value())
-        glDeleteProgram(id.value());
+    fragmentShader.reset();
+    vertexShader.reset();
 }
 
 bool Program::registerShader(const char *source, ShaderType type) {
@@ -32,6 +59,7 @@ bool Program::registerShader(const char *source, ShaderType type) {
         return false;
     }
 
+    labelGlObject(GL_SHADER, shader, isFragmentShader ? "fragment shader" : "vertex shader");
     if (isFragmentShader) fragmentShader = shader;
     else vertexShader = shader;
 
@@ -39,7 +67,7 @@ bool Program::registerShader(const char *source, ShaderType type) {
 }
 
 bool Program::registerProgram() {
-    if (id.has_value()) {
+    if (program) {
         error("Program is already registered");
         return false;
     }
@@ -49,21 +77,27 @@ bool Program::registerProgram() {
         return false;
     }
 
-    id = glCreateProgram();
-    glAttachShader(id.value(), vertexShader.value());
-    glAttachShader(id.value(), fragmentShader.value());
-    glLinkProgram(id.value());
+    program = gpuResources().create<GpuResourceType::Program>();
+    const GLuint id = program.id();
+    glAttachShader(id, vertexShader.value());
+    glAttachShader(id, fragmentShader.value());
+    glLinkProgram(id);
 
     int success = {};
-    glGetProgramiv(id.value(), GL_LINK_STATUS, &success);
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
     if (!success) {
         char errorMessage[1024] = {};
-        glGetProgramInfoLog(id.value(), 1024, nullptr, errorMessage);
+        glGetProgramInfoLog(id, 1024, nullptr, errorMessage);
         error("Failed to link program: " << errorMessage);
+        program.reset();
         return false;
     }
 
-    glUseProgram(id.value());
+    // Linked programs keep working without their shaders
+    glDetachShader(id, vertexShader.value());
+    glDetachShader(id, fragmentShader.value());
+    deleteShaders();
+    glUseProgram(id);
 
     return true;
 }
@@ -2,6 +2,8 @@
 
 #include <optional>
 
+#include "gpu_resources.h"
+
 struct Program {
     enum ShaderType {
         Fragment,
@@ -11,13 +13,23 @@ struct Program {
     public:
     Program();
     ~Program();
+    // Shaders are plain GL names, so moves hand them over explicitly
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+    Program(Program&& other) noexcept;
+    Program& operator=(Program&& other) noexcept;
+
     bool registerShader(const char* source, ShaderType type);
     bool registerProgram();
-    [[nodiscard]] unsigned int getId() { return id.value(); }
-    [[nodiscard]] bool isRegistered() { return id.has_value(); }
+    // Must run while the GL context is still alive
+    void destroy();
+    [[nodiscard]] unsigned int getId() const { return program.id(); }
+    [[nodiscard]] bool isRegistered() const { return static_cast<bool>(program); }
 
     private:
-    std::optional<unsigned int> id;
+    void deleteShaders();
+
+    GpuProgram program;
     std::optional<unsigned int> fragmentShader;
     std::optional<unsigned int> vertexShader;
 };
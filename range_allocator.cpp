@@ -0,0 +1,214 @@
+#include <algorithm>
+
+#include "range_allocator.h"
+
+namespace {
+
+int log2(size_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+int lowestBit(uint32_t value) {
+    return __builtin_ctz(value);
+}
+
+int highestBit(uint32_t value) {
+    return 31 - __builtin_clz(value);
+}
+
+size_t roundUp(size_t size) {
+    const size_t granularity = RangeAllocator::granularity;
+    return std::max<size_t>((size + granularity - 1) / granularity, 1) * granularity;
+}
+
+} // namespace
+
+RangeAllocator::RangeAllocator(size_t capacity) {
+    for (auto& level : heads)
+        std::fill(std::begin(level), std::end(level), invalid);
+
+    totalSize = capacity / granularity * granularity;
+    if (totalSize == 0)
+        return;
+    const uint32_t block = newBlock();
+    blocks[block] = {0, static_cast<uint32_t>(totalSize), invalid, invalid, invalid, invalid, true};
+    firstBlock = block;
+    lastBlock = block;
+    insertFree(block);
+}
+
+void RangeAllocator::mapping(size_t size, int& first, int& second) {
+    const size_t units = size / granularity;
+    if (units < secondLevels) {
+        first = 0;
+        second = static_cast<int>(units);
+        return;
+    }
+    const int bits = log2(units);
+    first = bits - secondLevelBits + 1;
+    second = static_cast<int>(units >> (bits - secondLevelBits)) & (secondLevels - 1);
+}
+
+uint32_t RangeAllocator::newBlock() {
+    if (!unusedBlocks.empty()) {
+        const uint32_t block = unusedBlocks.back();
+        unusedBlocks.pop_back();
+        return block;
+    }
+    blocks.emplace_back();
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void RangeAllocator::insertFree(uint32_t block) {
+    auto& entry = blocks[block];
+    int first = 0;
+    int second = 0;
+    mapping(entry.size, first, second);
+    entry.free = true;
+    entry.previousFree = invalid;
+    entry.nextFree = heads[first][second];
+    if (entry.nextFree != invalid)
+        blocks[entry.nextFree].previousFree = block;
+    heads[first][second] = block;
+    firstLevelBitmap |= 1u << first;
+    secondLevelBitmaps[first] |= 1u << second;
+    freeSize += entry.size;
+}
+
+void RangeAllocator::removeFree(uint32_t block) {
+    auto& entry = blocks[block];
+    int first = 0;
+    int second = 0;
+    mapping(entry.size, first, second);
+    if (entry.previousFree != invalid)
+        blocks[entry.previousFree].nextFree = entry.nextFree;
+    else
+        heads[first][second] = entry.nextFree;
+    if (entry.nextFree != invalid)
+        blocks[entry.nextFree].previousFree = entry.previousFree;
+
+    if (heads[first][second] == invalid) {
+        secondLevelBitmaps[first] &= ~(1u << second);
+        if (secondLevelBitmaps[first] == 0)
+            firstLevelBitmap &= ~(1u << first);
+    }
+    entry.free = false;
+    freeSize -= entry.size;
+}
+
+uint32_t RangeAllocator::findFree(size_t size) const {
+    // Round up to the next class start so any block in the list found is large enough
+    size_t units = size / granularity;
+    if (units >= secondLevels)
+        units += (size_t(1) << (log2(units) - secondLevelBits)) - 1;
+    int first = 0;
+    int second = 0;
+    mapping(units * granularity, first, second);
+    if (first >= firstLevels)
+        return invalid;
+
+    uint32_t secondMap = secondLevelBitmaps[first] & (~0u << second);
+    if (!secondMap) {
+        const uint32_t firstMap = first + 1 < firstLevels ? firstLevelBitmap & (~0u << (first + 1)) : 0;
+        if (!firstMap)
+            return invalid;
+        first = lowestBit(firstMap);
+        secondMap = secondLevelBitmaps[first];
+    }
+    return heads[first][lowestBit(secondMap)];
+}
+
+void RangeAllocator::split(uint32_t block, size_t size) {
+    const size_t remaining = blocks[block].size - size;
+    if (remaining < granularity)
+        return;
+
+    const uint32_t rest = newBlock();
+    auto& entry = blocks[block];
+    blocks[rest] = {
+        static_cast<uint32_t>(entry.offset + size), static_cast<uint32_t>(remaining),
+        block, entry.next, invalid, invalid, true,
+    };
+    if (entry.next != invalid)
+        blocks[entry.next].previous = rest;
+    else
+        lastBlock = rest;
+    entry.next = rest;
+    entry.size = static_cast<uint32_t>(size);
+    insertFree(rest);
+}
+
+uint32_t RangeAllocator::use(uint32_t block, size_t size) {
+    removeFree(block);
+    split(block, size);
+    return block;
+}
+
+uint32_t RangeAllocator::allocate(size_t size) {
+    size = roundUp(size);
+    const uint32_t block = findFree(size);
+    return block == invalid ? invalid : use(block, size);
+}
+
+uint32_t RangeAllocator::allocateBelow(size_t size, size_t limit) {
+    size = roundUp(size);
+    for (uint32_t block = firstBlock; block != invalid && blocks[block].offset < limit; block = blocks[block].next) {
+        if (!blocks[block].free || blocks[block].size < size)
+            continue;
+        // Has to end before the range it replaces would start
+        if (blocks[block].offset + size > limit)
+            return invalid;
+        return use(block, size);
+    }
+    return invalid;
+}
+
+void RangeAllocator::free(uint32_t block) {
+    // Merge with free neighbours, the survivor is the lowest block
+    const uint32_t next = blocks[block].next;
+    if (next != invalid && blocks[next].free) {
+        removeFree(next);
+        blocks[block].size += blocks[next].size;
+        blocks[block].next = blocks[next].next;
+        if (blocks[next].next != invalid)
+            blocks[blocks[next].next].previous = block;
+        else
+            lastBlock = block;
+        unusedBlocks.push_back(next);
+    }
+    const uint32_t previous = blocks[block].previous;
+    if (previous != invalid && blocks[previous].free) {
+        removeFree(previous);
+        blocks[previous].size += blocks[block].size;
+        blocks[previous].next = blocks[block].next;
+        if (blocks[block].next != invalid)
+            blocks[blocks[block].next].previous = previous;
+        else
+            lastBlock = previous;
+        unusedBlocks.push_back(block);
+        block = previous;
+    }
+    insertFree(block);
+}
+
+uint32_t RangeAllocator::previousUsed(uint32_t block) const {
+    block = block == invalid ? lastBlock : blocks[block].previous;
+    while (block != invalid && blocks[block].free)
+        block = blocks[block].previous;
+    return block;
+}
+
+size_t RangeAllocator::largestFree() const {
+    if (!firstLevelBitmap)
+        return 0;
+    const int first = highestBit(firstLevelBitmap);
+    const int second = highestBit(secondLevelBitmaps[first]);
+    size_t largest = 0;
+    for (uint32_t block = heads[first][second]; block != invalid; block = blocks[block].nextFree)
+        largest = std::max<size_t>(largest, blocks[block].size);
+    return largest;
+}
+
+float RangeAllocator::fragmentation() const {
+    return freeSize ? 1.0f - static_cast<float>(largestFree()) / freeSize : 0.0f;
+}
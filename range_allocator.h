@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit (TLSF) allocator for ranges of an address space it
+// never touches, such as a GL buffer. Free ranges sit in size class lists
+// (power of two classes split into 8 linear steps) found through two bitmaps,
+// so allocate() and free() take constant time whatever the number of ranges.
+// Neighbours are merged on free.
+//
+// Sizes and offsets are multiples of `granularity` bytes. Ranges are named by
+// block indices that stay valid until the range is freed.
+struct RangeAllocator {
+    public:
+    static constexpr uint32_t granularity = 16;
+    static constexpr uint32_t invalid = ~0u;
+
+    explicit RangeAllocator(size_t capacity = 0);
+
+    // Returns a block index or invalid when no free range is large enough
+    uint32_t allocate(size_t size);
+    // Lowest free range of at least `size` bytes that starts below `limit`,
+    // found by walking the ranges in address order: O(ranges), for compaction
+    uint32_t allocateBelow(size_t size, size_t limit);
+    void free(uint32_t block);
+
+    [[nodiscard]] size_t offset(uint32_t block) const { return blocks[block].offset; }
+    [[nodiscard]] size_t size(uint32_t block) const { return blocks[block].size; }
+    // Allocated block with the highest offset before `block`, or the last one
+    // overall for invalid
+    [[nodiscard]] uint32_t previousUsed(uint32_t block) const;
+
+    [[nodiscard]] size_t capacity() const { return totalSize; }
+    [[nodiscard]] size_t freeBytes() const { return freeSize; }
+    [[nodiscard]] size_t largestFree() const;
+    // 0 when the free space is one range, close to 1 when it is scattered
+    [[nodiscard]] float fragmentation() const;
+
+    private:
+    static constexpr int firstLevels = 32;
+    static constexpr int secondLevelBits = 3;
+    static constexpr int secondLevels = 1 << secondLevelBits;
+
+    struct Block {
+        uint32_t offset; // In bytes
+        uint32_t size;
+        uint32_t previous; // Physical neighbours
+        uint32_t next;
+        uint32_t previousFree; // Size class list, only while free
+        uint32_t nextFree;
+        bool free;
+    };
+
+    static void mapping(size_t size, int& first, int& second);
+    uint32_t newBlock();
+    void insertFree(uint32_t block);
+    void removeFree(uint32_t block);
+    uint32_t findFree(size_t size) const;
+    // Shrinks a free block to `size` (already removed from its list), the rest
+    // becomes a new free block
+    void split(uint32_t block, size_t size);
+    uint32_t use(uint32_t block, size_t size);
+
+    std::vector<Block> blocks;
+    std::vector<uint32_t> unusedBlocks;
+    uint32_t firstBlock = invalid;
+    uint32_t lastBlock = invalid;
+    uint32_t firstLevelBitmap = 0;
+    uint32_t secondLevelBitmaps[firstLevels] = {};
+    uint32_t heads[firstLevels][secondLevels];
+    size_t totalSize = 0;
+    size_t freeSize = 0;
+};
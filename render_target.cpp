@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include "render_target.h"
+#include "gl_debug.h"
+#include "logs.h"
+#include "stats.h"
+
+namespace {
+
+int roundUpToBucket(int size) {
+    const int bucket = RenderTarget::bucketSize;
+    return std::max((size + bucket - 1) / bucket, 1) * bucket;
+}
+
+} // namespace
+
+RenderTarget::~RenderTarget() {
+    destroy();
+}
+
+void RenderTarget::init(const char* name) {
+    label = name;
+    framebuffer = gpuResources().create<GpuResourceType::Framebuffer>();
+    texture = gpuResources().create<GpuResourceType::Texture>();
+}
+
+void RenderTarget::destroy() {
+    framebuffer.reset();
+    texture.reset();
+    allocatedWidth = 0;
+    allocatedHeight = 0;
+}
+
+bool RenderTarget::resize(GlState& gl, int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    const int bucketWidth = roundUpToBucket(width);
+    const int bucketHeight = roundUpToBucket(height);
+
+    // Grow right away, keeping the other dimension if that one shrank
+    if (bucketWidth > allocatedWidth || bucketHeight > allocatedHeight) {
+        allocate(gl, std::max(bucketWidth, allocatedWidth), std::max(bucketHeight, allocatedHeight));
+        return true;
+    }
+
+    if (bucketWidth == allocatedWidth && bucketHeight == allocatedHeight) {
+        oversizedCalls = 0;
+        return false;
+    }
+    if (++oversizedCalls < shrinkDelay)
+        return false;
+    allocate(gl, bucketWidth, bucketHeight);
+    return true;
+}
+
+void RenderTarget::allocate(GlState& gl, int newWidth, int newHeight) {
+    allocatedWidth = newWidth;
+    allocatedHeight = newHeight;
+    oversizedCalls = 0;
+    frameCounters().renderTargetAllocations++;
+    debug("Render target " << label << " allocated at " << allocatedWidth << "x" << allocatedHeight);
+
+    gl.activeTexture(GL_TEXTURE0);
+    gl.bindTexture(GL_TEXTURE_2D, texture.id());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, allocatedWidth, allocatedHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    texture.setMemory(static_cast<size_t>(allocatedWidth) * allocatedHeight * 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    labelGlObject(GL_TEXTURE, texture.id(), label);
+
+    gl.bindFramebuffer(GL_FRAMEBUFFER, framebuffer.id());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id(), 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        error("Render target " << label << " is incomplete");
+    labelGlObject(GL_FRAMEBUFFER, framebuffer.id(), label);
+}
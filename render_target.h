@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+
+// Color texture plus framebuffer that follows the window size cheaply. The
+// storage is allocated in buckets of bucketSize pixels and only shrinks once
+// the requested size stayed at least a bucket below it for shrinkDelay
+// consecutive resize() calls, so dragging a window edge reallocates a handful
+// of times instead of on every frame. Only the bottom left width x height
+// corner is in use, sample it with getUvScale().
+struct RenderTarget {
+    public:
+    static constexpr int bucketSize = 256;
+    static constexpr int shrinkDelay = 120;
+
+    RenderTarget() = default;
+    ~RenderTarget();
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    void init(const char* label);
+    // Must run while the GL context is still alive
+    void destroy();
+
+    // Sets the size in use, returns true when the storage had to be reallocated
+    bool resize(GlState& gl, int width, int height);
+
+    [[nodiscard]] GLuint getFramebuffer() const { return framebuffer.id(); }
+    [[nodiscard]] GLuint getTexture() const { return texture.id(); }
+    [[nodiscard]] int getWidth() const { return width; }
+    [[nodiscard]] int getHeight() const { return height; }
+    [[nodiscard]] float getUScale() const { return allocatedWidth ? float(width) / allocatedWidth : 0; }
+    [[nodiscard]] float getVScale() const { return allocatedHeight ? float(height) / allocatedHeight : 0; }
+
+    private:
+    void allocate(GlState& gl, int width, int height);
+
+    const char* label = nullptr;
+    GpuFramebuffer framebuffer;
+    GpuTexture texture;
+    int width = 0;
+    int height = 0;
+    int allocatedWidth = 0;
+    int allocatedHeight = 0;
+    int oversizedCalls = 0;
+};
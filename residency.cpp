@@ -0,0 +1,248 @@
+#include <algorithm>
+
+#include "residency.h"
+#include "logs.h"
+#include "stats.h"
+
+namespace {
+
+constexpr uint32_t indexMask = (1u << 20) - 1;
+
+} // namespace
+
+void ResidencyManager::setLimits(size_t newBudget, size_t newLoadBytesPerFrame) {
+    budget = newBudget;
+    loadBytesPerFrame = newLoadBytesPerFrame;
+}
+
+size_t ResidencyManager::trackedBytes() {
+    size_t bytes = 0;
+    for (int i = 0; i < static_cast<int>(GpuResourceType::Count); i++)
+        bytes += gpuResources().stats(static_cast<GpuResourceType>(i)).bytes;
+    return bytes;
+}
+
+uint32_t ResidencyManager::add(size_t size, int priority, LoadFunction load, void* userData) {
+    uint32_t index = 0;
+    if (!freeEntries.empty()) {
+        index = freeEntries.back();
+        freeEntries.pop_back();
+    } else {
+        index = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+        entries[index].generation = 1;
+    }
+    auto& entry = entries[index];
+    entry.live = true;
+    entry.pending = false;
+    entry.failed = false;
+    entry.priority = priority;
+    entry.size = size;
+    entry.load = load;
+    entry.userData = userData;
+    entry.lastUsed = 0;
+    entry.newer = none;
+    entry.older = none;
+    streamable++;
+    return entry.generation << indexBits | index;
+}
+
+ResidencyManager::Entry* ResidencyManager::find(uint32_t handle) {
+    return const_cast<Entry*>(static_cast<const ResidencyManager*>(this)->find(handle));
+}
+
+const ResidencyManager::Entry* ResidencyManager::find(uint32_t handle) const {
+    const uint32_t index = handle & indexMask;
+    if (index >= entries.size() || !entries[index].live || entries[index].generation != handle >> indexBits)
+        return nullptr;
+    return &entries[index];
+}
+
+void ResidencyManager::remove(uint32_t handle) {
+    Entry* entry = find(handle);
+    if (!entry)
+        return;
+    const uint32_t index = handle & indexMask;
+    if (entry->buffer) {
+        unlink(index);
+        resident--;
+        residentBytes -= entry->size;
+    }
+    if (entry->pending)
+        queue.erase(std::find(queue.begin(), queue.end(), index));
+    entry->live = false;
+    entry->buffer.reset();
+    entry->generation = std::max((entry->generation + 1) & ((1u << (32 - indexBits)) - 1), 1u);
+    freeEntries.push_back(index);
+    streamable--;
+}
+
+void ResidencyManager::unlink(uint32_t index) {
+    auto& entry = entries[index];
+    if (entry.newer != none)
+        entries[entry.newer].older = entry.older;
+    else
+        newest = entry.older;
+    if (entry.older != none)
+        entries[entry.older].newer = entry.newer;
+    else
+        oldest = entry.newer;
+    entry.newer = none;
+    entry.older = none;
+}
+
+void ResidencyManager::linkFront(uint32_t index) {
+    auto& entry = entries[index];
+    entry.newer = none;
+    entry.older = newest;
+    if (newest != none)
+        entries[newest].newer = index;
+    newest = index;
+    if (oldest == none)
+        oldest = index;
+}
+
+GLuint ResidencyManager::use(uint32_t handle) {
+    Entry* entry = find(handle);
+    if (!entry)
+        return 0;
+    const uint32_t index = handle & indexMask;
+    entry->lastUsed = frame;
+    if (entry->buffer) {
+        if (newest != index) {
+            unlink(index);
+            linkFront(index);
+        }
+        return entry->buffer.id();
+    }
+    if (!entry->pending && !entry->failed) {
+        entry->pending = true;
+        entry->requested = frame;
+        queue.push_back(index);
+    }
+    return 0;
+}
+
+bool ResidencyManager::isResident(uint32_t handle) const {
+    const Entry* entry = find(handle);
+    return entry && entry->buffer;
+}
+
+void ResidencyManager::evict(uint32_t index) {
+    auto& entry = entries[index];
+    unlink(index);
+    // The registry only deletes it once frames still in flight are done
+    entry.buffer.reset();
+    resident--;
+    residentBytes -= entry.size;
+    evictions++;
+}
+
+bool ResidencyManager::makeRoom(size_t bytes) {
+    if (budget == 0)
+        return true;
+    while (trackedBytes() + bytes > budget) {
+        // Buffers drawn last frame stay, evicting them would only bring them back
+        if (oldest == none || entries[oldest].lastUsed + 1 >= frame)
+            return false;
+        evict(oldest);
+    }
+    return true;
+}
+
+ResidencyManager::LoadResult ResidencyManager::load(GlState& gl, uint32_t index) {
+    auto& entry = entries[index];
+    entry.buffer = gpuResources().create<GpuResourceType::Buffer>();
+    if (!entry.buffer)
+        return LoadResult::GlFailed;
+
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, entry.buffer.id());
+    glBufferData(GL_COPY_WRITE_BUFFER, entry.size, nullptr, GL_STATIC_DRAW);
+    void* destination = glMapBufferRange(
+        GL_COPY_WRITE_BUFFER, 0, entry.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+    );
+    LoadResult result = LoadResult::GlFailed;
+    if (destination)
+        result = entry.load(entry.userData, destination, entry.size) ? LoadResult::Loaded : LoadResult::SourceFailed;
+    // GL may lose mapped contents, for example on a mode switch
+    if (destination && !glUnmapBuffer(GL_COPY_WRITE_BUFFER) && result == LoadResult::Loaded)
+        result = LoadResult::GlFailed;
+    if (result != LoadResult::Loaded) {
+        entry.buffer.reset();
+        return result;
+    }
+
+    entry.buffer.setMemory(entry.size);
+    frameCounters().bytesUploaded += entry.size;
+    frameCounters().uploadCalls++;
+    linkFront(index);
+    resident++;
+    residentBytes += entry.size;
+    loads++;
+    return LoadResult::Loaded;
+}
+
+void ResidencyManager::update(GlState& gl, uint32_t newFrame) {
+    frame = newFrame;
+    if (budget > 0 && trackedBytes() > budget)
+        makeRoom(0);
+    if (queue.empty())
+        return;
+
+    std::sort(queue.begin(), queue.end(), [this](uint32_t a, uint32_t b) {
+        if (entries[a].priority != entries[b].priority)
+            return entries[a].priority > entries[b].priority;
+        return entries[a].requested < entries[b].requested;
+    });
+
+    size_t loadedBytes = 0;
+    size_t done = 0;
+    for (; done < queue.size(); done++) {
+        auto& entry = entries[queue[done]];
+        // The first load always runs, however large
+        if (done > 0 && loadedBytes + entry.size > loadBytesPerFrame)
+            break;
+        if (!makeRoom(entry.size)) {
+            warning_throttled(
+                LogCategory::GL,
+                "Buffers in use exceed the GPU budget of " << budget / (1024 * 1024) << " MiB, "
+                << queue.size() - done << " loads waiting"
+            );
+            break;
+        }
+        entry.pending = false;
+        const LoadResult result = load(gl, queue[done]);
+        if (result != LoadResult::Loaded) {
+            // A GL failure leaves the entry unloaded, the next use() queues it again
+            entry.failed = result == LoadResult::SourceFailed;
+            loadFailures++;
+            error_throttled(
+                LogCategory::GL, "Could not load a streamed buffer of " << entry.size << " bytes"
+                << (entry.failed ? ", its source failed" : ", will retry")
+            );
+            continue;
+        }
+        loadedBytes += entry.size;
+    }
+    queue.erase(queue.begin(), queue.begin() + done);
+}
+
+void ResidencyManager::destroy() {
+    for (auto& entry : entries)
+        entry.buffer.reset();
+    entries.clear();
+    freeEntries.clear();
+    queue.clear();
+    newest = none;
+    oldest = none;
+    streamable = 0;
+    resident = 0;
+    residentBytes = 0;
+}
+
+ResidencyManager::Stats ResidencyManager::stats() const {
+    return {
+        budget, trackedBytes(), residentBytes, streamable, resident,
+        static_cast<uint32_t>(queue.size()), loads, evictions, loadFailures,
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+
+// Keeps GPU memory within a budget. Usage is everything GpuResources knows the
+// size of; only streamable buffers registered here can be evicted to make
+// room. A streamable buffer is created by loading it from its source (a CPU
+// copy or a file, behind a load callback) and evicted by dropping the GPU copy,
+// least recently used first. Objects released but not yet deleted (see
+// GpuResources) no longer count.
+//
+// use() returns 0 for buffers that are not resident and queues a load; update()
+// runs queued loads by priority, then age, up to a byte limit per frame. Data
+// is loaded straight into a mapping of the new buffer.
+struct ResidencyManager {
+    public:
+    // Fills `destination` with `size` bytes, false if the source failed
+    using LoadFunction = bool (*)(void* userData, void* destination, size_t size);
+
+    struct Stats {
+        size_t budget; // 0 for unlimited
+        size_t usedBytes; // All tracked GPU memory
+        size_t residentBytes; // Streamable buffers on the GPU
+        uint32_t streamable;
+        uint32_t resident;
+        uint32_t pending; // Waiting for a load
+        uint64_t loads; // Since startup
+        uint64_t evictions;
+        uint64_t loadFailures;
+    };
+
+    ResidencyManager() = default;
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+    // budget 0 disables eviction
+    void setLimits(size_t budget, size_t loadBytesPerFrame);
+
+    // Higher priorities load first. Nothing is loaded before the first use().
+    uint32_t add(size_t size, int priority, LoadFunction load, void* userData);
+    void remove(uint32_t handle);
+
+    // Buffer to draw from this frame, or 0 while it is not resident
+    GLuint use(uint32_t handle);
+    [[nodiscard]] bool isResident(uint32_t handle) const;
+
+    // Call at the start of every frame, before any use(). Loads what earlier
+    // frames asked for.
+    void update(GlState& gl, uint32_t frame);
+    void destroy();
+
+    [[nodiscard]] Stats stats() const;
+
+    private:
+    static constexpr uint32_t indexBits = 20;
+    static constexpr uint32_t none = ~0u;
+
+    struct Entry {
+        uint32_t generation;
+        bool live;
+        bool pending;
+        bool failed; // The source failed, not retried until removed and added again
+        int priority;
+        size_t size;
+        LoadFunction load;
+        void* userData;
+        GpuBuffer buffer;
+        uint32_t lastUsed; // Frame
+        uint32_t requested; // Frame the pending load was queued
+        uint32_t newer; // LRU list of resident entries, most recent at the head
+        uint32_t older;
+    };
+
+    Entry* find(uint32_t handle);
+    [[nodiscard]] const Entry* find(uint32_t handle) const;
+    void unlink(uint32_t index);
+    void linkFront(uint32_t index);
+    void evict(uint32_t index);
+    // Evicts buffers unused this frame until `bytes` more fit, false if they can't
+    bool makeRoom(size_t bytes);
+    // GL failures are worth another try on the next use(), source failures are not
+    enum class LoadResult { Loaded, GlFailed, SourceFailed };
+    LoadResult load(GlState& gl, uint32_t index);
+    static size_t trackedBytes();
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeEntries;
+    std::vector<uint32_t> queue; // Entry indices with a pending load
+    uint32_t newest = none;
+    uint32_t oldest = none;
+    uint32_t frame = 0;
+    size_t budget = 0;
+    size_t loadBytesPerFrame = 8 << 20;
+    uint32_t streamable = 0;
+    uint32_t resident = 0;
+    size_t residentBytes = 0;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+    uint64_t loadFailures = 0;
+};
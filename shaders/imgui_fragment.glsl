@@ -0,0 +1,12 @@
+#version 410 core
+
+layout(location = 0) in vec2 fragmentUv;
+layout(location = 1) in vec4 fragmentColor;
+
+layout(location = 0) out vec4 finalColor;
+
+uniform sampler2D fontTexture;
+
+void main() {
+    finalColor = fragmentColor * texture(fontTexture, fragmentUv);
+}
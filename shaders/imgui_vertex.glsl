@@ -0,0 +1,16 @@
+#version 410 core
+
+layout(location = 0) in vec2 vertexPosition;
+layout(location = 1) in vec2 vertexUv;
+layout(location = 2) in vec4 vertexColor;
+
+layout(location = 0) out vec2 fragmentUv;
+layout(location = 1) out vec4 fragmentColor;
+
+uniform mat4 projection;
+
+void main() {
+    gl_Position = projection * vec4(vertexPosition, 0.0, 1.0);
+    fragmentUv = vertexUv;
+    fragmentColor = vertexColor;
+}
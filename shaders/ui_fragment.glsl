@@ -0,0 +1,11 @@
+#version 410 core
+
+layout(location = 0) in vec2 uv;
+
+layout(location = 0) out vec4 finalColor;
+
+uniform sampler2D uiTexture;
+
+void main() {
+    finalColor = texture(uiTexture, uv);
+}
@@ -0,0 +1,13 @@
+#version 410 core
+
+layout(location = 0) out vec2 uv;
+
+// Part of the texture in use, it may be allocated larger than the window
+uniform vec2 uvScale = vec2(1.0);
+
+void main() {
+    // Full-screen triangle from the vertex index, no vertex buffer needed
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = position * uvScale;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
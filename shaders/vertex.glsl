@@ -5,7 +5,15 @@ layout(location = 1) in vec3 vertexColor;
 
 layout(location = 0) out vec3 fragmentColor;
 
+// Instances are laid out on a square grid covering the viewport
+uniform int instanceCount = 1;
+
 void main() {
-    gl_Position = vec4(vertexPosition, 1.0);
+    int side = int(ceil(sqrt(float(instanceCount))));
+    float scale = 1.0 / float(side);
+    vec2 cell = vec2(gl_InstanceID % side, gl_InstanceID / side);
+    vec2 offset = (cell + 0.5) * 2.0 * scale - 1.0;
+
+    gl_Position = vec4(vertexPosition.xy * scale + offset, vertexPosition.z, 1.0);
     fragmentColor = vertexColor;
 }
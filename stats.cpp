@@ -0,0 +1,232 @@
+#include <chrono>
+
+#include <sys/resource.h>
+
+#include "stats.h"
+#include "logs.h"
+#include "trace.h"
+
+namespace {
+
+FrameCounters counters = {};
+
+const char* const phaseNames[] = {"Events", "UI", "Scene", "Upload", "UI render", "Outputs", "Swap"};
+static_assert(sizeof(phaseNames) / sizeof(*phaseNames) == static_cast<int>(FramePhase::Count));
+
+HeapCounters heapDelta(const HeapCounters& now, const HeapCounters& start) {
+    return {now.allocations - start.allocations, now.bytes - start.bytes, now.frees - start.frees};
+}
+
+} // namespace
+
+const char* framePhaseName(FramePhase phase) {
+    return phaseNames[static_cast<int>(phase)];
+}
+
+FrameCounters& frameCounters() {
+    return counters;
+}
+
+ActivityMeter::ActivityMeter() {
+    windowStart = Trace::now() / 1e9;
+    cpuAtStart = cpuSeconds();
+}
+
+void ActivityMeter::frame(bool wasRendered) {
+    static const TraceEvent<uint32_t, uint32_t, float> activityEvent(
+        "activity", {"rendered", "skipped", "cpuMsPerSecond"}
+    );
+
+    if (wasRendered)
+        rendered++;
+    else
+        skipped++;
+
+    const double now = Trace::now() / 1e9;
+    const double elapsed = now - windowStart;
+    if (elapsed < 1.0)
+        return;
+
+    // Normalized, a long wait can stretch the window past one second
+    const double cpu = cpuSeconds();
+    stats.framesRendered = static_cast<uint32_t>(rendered / elapsed + 0.5);
+    stats.framesSkipped = static_cast<uint32_t>(skipped / elapsed + 0.5);
+    stats.cpuMsPerSecond = static_cast<float>((cpu - cpuAtStart) * 1000 / elapsed);
+    activityEvent(stats.framesRendered, stats.framesSkipped, stats.cpuMsPerSecond);
+
+    rendered = 0;
+    skipped = 0;
+    windowStart = now;
+    cpuAtStart = cpu;
+}
+
+double ActivityMeter::cpuSeconds() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](const timeval& time) { return time.tv_sec + time.tv_usec / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+void AllocationAudit::record(const FrameStats& stats) {
+    if (budget < 0 || stats.frame < warmupFrames)
+        return;
+    auditedFrames++;
+    const uint64_t allocations = stats.heap.allocations;
+    if (allocations > worstAllocations) {
+        worstAllocations = allocations;
+        worstFrame = stats.frame;
+    }
+    if (allocations <= static_cast<uint64_t>(budget))
+        return;
+    failedFrames++;
+    warning_throttled(
+        LogCategory::Frame,
+        "Frame " << stats.frame << " allocated " << allocations << " times ("
+        << stats.threadHeap.allocations << " on the render thread), budget is " << budget
+    );
+}
+
+void AllocationAudit::report() const {
+    if (budget < 0)
+        return;
+    if (auditedFrames == 0) {
+        warning("Allocation audit: no frames past the warmup of " << warmupFrames);
+        return;
+    }
+    if (passed()) {
+        info(
+            "Allocation audit passed: " << auditedFrames << " frames, at most " << worstAllocations
+            << " allocations per frame, budget " << budget
+        );
+    } else {
+        error(
+            "Allocation audit failed: " << failedFrames << " of " << auditedFrames << " frames over the budget of "
+            << budget << ", worst was frame " << worstFrame << " with " << worstAllocations << " allocations"
+        );
+    }
+}
+
+FrameProfiler::FrameProfiler() {
+    for (auto& ms : lastGpuMs)
+        ms = -1.0f;
+}
+
+FrameProfiler::~FrameProfiler() {
+    destroy();
+}
+
+void FrameProfiler::destroy() {
+    if (!queriesCreated)
+        return;
+    for (auto& gpuFrame : gpuFrames)
+        glDeleteQueries(phaseCount + 1, gpuFrame.queries);
+    queriesCreated = false;
+}
+
+int64_t FrameProfiler::now() const {
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    return duration_cast<nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void FrameProfiler::beginFrame(uint32_t frame, bool enableGpuTiming) {
+    gpuTiming = enableGpuTiming;
+    if (gpuTiming && !queriesCreated) {
+        for (auto& gpuFrame : gpuFrames) {
+            glGenQueries(phaseCount + 1, gpuFrame.queries);
+            gpuFrame.pending = false;
+        }
+        queriesCreated = true;
+    }
+
+    stats = {};
+    stats.frame = frame;
+    counters = {};
+    heapAtStart = heapCounters();
+    threadHeapAtStart = threadHeapCounters();
+    imguiHeapAtStart = imguiHeapCounters();
+
+    frameStart = now();
+    phaseStart = frameStart;
+    inputTime = frameStart;
+    currentPhase = -1;
+
+    if (gpuTiming) {
+        slot = (slot + 1) % framesInFlight;
+        auto& gpuFrame = gpuFrames[slot];
+        // Oldest frame in the ring, its queries have had framesInFlight frames to finish
+        if (gpuFrame.pending)
+            collectGpu(gpuFrame);
+        gpuFrame.frame = frame;
+        for (auto& issued : gpuFrame.issued)
+            issued = false;
+    }
+}
+
+void FrameProfiler::beginPhase(FramePhase phase) {
+    const int64_t time = now();
+    if (currentPhase >= 0)
+        stats.cpuMs[currentPhase] += (time - phaseStart) / 1e6f;
+    currentPhase = static_cast<int>(phase);
+    phaseStart = time;
+    if (phase == FramePhase::Events)
+        inputTime = time;
+
+    if (gpuTiming) {
+        auto& gpuFrame = gpuFrames[slot];
+        glQueryCounter(gpuFrame.queries[currentPhase], GL_TIMESTAMP);
+        gpuFrame.issued[currentPhase] = true;
+    }
+}
+
+FrameStats FrameProfiler::endFrame() {
+    const int64_t time = now();
+    if (currentPhase >= 0)
+        stats.cpuMs[currentPhase] += (time - phaseStart) / 1e6f;
+    stats.frameMs = (time - frameStart) / 1e6f;
+    stats.latencyMs = (time - inputTime) / 1e6f;
+    currentPhase = -1;
+
+    if (gpuTiming) {
+        auto& gpuFrame = gpuFrames[slot];
+        glQueryCounter(gpuFrame.queries[phaseCount], GL_TIMESTAMP);
+        gpuFrame.issued[phaseCount] = true;
+        gpuFrame.pending = true;
+    }
+
+    stats.counters = counters;
+    stats.heap = heapDelta(heapCounters(), heapAtStart);
+    stats.threadHeap = heapDelta(threadHeapCounters(), threadHeapAtStart);
+    stats.imguiHeap = heapDelta(imguiHeapCounters(), imguiHeapAtStart);
+    stats.gpuFrame = lastGpuFrame;
+    for (int i = 0; i < phaseCount; i++)
+        stats.gpuMs[i] = lastGpuMs[i];
+    return stats;
+}
+
+void FrameProfiler::collectGpu(GpuFrame& gpuFrame) {
+    gpuFrame.pending = false;
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(gpuFrame.queries[phaseCount], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return; // Driver is lagging more than framesInFlight behind, skip this one
+
+    GLuint64 timestamps[phaseCount + 1] = {};
+    for (int i = 0; i <= phaseCount; i++) {
+        if (gpuFrame.issued[i])
+            glGetQueryObjectui64v(gpuFrame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    // A phase ends where the next issued one (or the frame) begins
+    for (int i = 0; i < phaseCount; i++) {
+        lastGpuMs[i] = -1.0f;
+        if (!gpuFrame.issued[i])
+            continue;
+        int next = i + 1;
+        while (!gpuFrame.issued[next])
+            next++;
+        lastGpuMs[i] = (timestamps[next] - timestamps[i]) / 1e6f;
+    }
+    lastGpuFrame = gpuFrame.frame;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "memory.h"
+
+// Parts of a frame, in the order they happen
+enum class FramePhase : uint8_t {
+    Events,
+    Ui,
+    Scene,
+    Upload,
+    UiRender,
+    Outputs,
+    Swap,
+    Count,
+};
+
+const char* framePhaseName(FramePhase phase);
+
+// Work done by the frame, incremented by GlState and friends
+struct FrameCounters {
+    uint32_t drawCalls;
+    uint64_t triangles;
+    uint64_t bytesUploaded;
+    uint32_t uploadCalls;
+    uint32_t glCallsFiltered;
+    uint32_t uiRedraws; // 1 when ImGui built and rendered a new frame
+    uint32_t renderTargetAllocations;
+    uint32_t outputWindows; // Extra windows rendered
+};
+
+FrameCounters& frameCounters();
+
+struct FrameStats {
+    uint32_t frame;
+    float frameMs;
+    float cpuMs[static_cast<int>(FramePhase::Count)];
+    // From sampling input (the Events phase) until the swap returned. With
+    // vsync and a glFinish after the swap that is when the frame was presented.
+    float latencyMs;
+    // Frames are queried asynchronously, these belong to frame `gpuFrame` and
+    // are negative when no GPU timings are available yet
+    uint32_t gpuFrame;
+    float gpuMs[static_cast<int>(FramePhase::Count)];
+    FrameCounters counters;
+    // Heap activity during the frame: every thread, the thread running the
+    // frame, and requests to ImGui's pool
+    HeapCounters heap;
+    HeapCounters threadHeap;
+    HeapCounters imguiHeap;
+};
+
+// Loop iterations and process CPU time over one wall clock second, the numbers
+// that matter for power use when rendering on demand
+struct ActivityStats {
+    uint32_t framesRendered;
+    uint32_t framesSkipped; // Wakeups that found nothing to redraw
+    float cpuMsPerSecond;   // User + system time of all threads
+};
+
+struct ActivityMeter {
+    public:
+    ActivityMeter();
+
+    // Call once per loop iteration, also traced as an `activity` event every second
+    void frame(bool rendered);
+    [[nodiscard]] const ActivityStats& lastSecond() const { return stats; }
+
+    private:
+    static double cpuSeconds();
+
+    ActivityStats stats = {};
+    uint32_t rendered = 0;
+    uint32_t skipped = 0;
+    double windowStart = 0;
+    double cpuAtStart = 0;
+};
+
+// Checks that frames past a warmup allocate at most `budget` times, for
+// automated runs that guard the render loop against new allocations
+struct AllocationAudit {
+    public:
+    // A negative budget disables the audit
+    AllocationAudit(int budget, uint32_t warmupFrames) : budget(budget), warmupFrames(warmupFrames) {}
+
+    void record(const FrameStats& stats);
+    [[nodiscard]] bool passed() const { return failedFrames == 0; }
+    // Logs the outcome, if enabled
+    void report() const;
+
+    private:
+    int budget;
+    uint32_t warmupFrames;
+    uint32_t auditedFrames = 0;
+    uint32_t failedFrames = 0;
+    uint64_t worstAllocations = 0;
+    uint32_t worstFrame = 0;
+};
+
+// CPU timings of frame phases plus GPU timings through timestamp queries.
+// Results of the GPU queries are read framesInFlight frames later so reading
+// them never stalls the pipeline.
+struct FrameProfiler {
+    public:
+    static constexpr int framesInFlight = 4;
+
+    FrameProfiler();
+    ~FrameProfiler();
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    void beginFrame(uint32_t frame, bool gpuTiming);
+    // Ends the previous phase and starts the next one
+    void beginPhase(FramePhase phase);
+    FrameStats endFrame();
+    // Must run while the GL context is still alive
+    void destroy();
+
+    private:
+    static constexpr int phaseCount = static_cast<int>(FramePhase::Count);
+
+    struct GpuFrame {
+        GLuint queries[phaseCount + 1];
+        bool issued[phaseCount + 1];
+        bool pending;
+        uint32_t frame;
+    };
+
+    void collectGpu(GpuFrame& slot);
+    int64_t now() const;
+
+    GpuFrame gpuFrames[framesInFlight];
+    bool queriesCreated = false;
+    bool gpuTiming = false;
+    int slot = 0;
+    int currentPhase = -1;
+    int64_t frameStart = 0;
+    int64_t phaseStart = 0;
+    int64_t inputTime = 0;
+    HeapCounters heapAtStart = {};
+    HeapCounters threadHeapAtStart = {};
+    HeapCounters imguiHeapAtStart = {};
+    FrameStats stats = {};
+    uint32_t lastGpuFrame = 0;
+    float lastGpuMs[phaseCount] = {};
+};
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TIME_SERIES_SSE2 1
+#endif
+
+#include "time_series.h"
+
+namespace {
+
+static_assert(TimeSeries::branchFactor == 8, "reduceBlocks() assumes blocks of 8");
+
+// Reduces blocks of 8 mins and 8 maxs to one min and max each
+void reduceBlocks(const float* mins, const float* maxs, size_t blocks, float* outMins, float* outMaxs) {
+#ifdef TIME_SERIES_SSE2
+    for (size_t block = 0; block < blocks; block++) {
+        const float* blockMins = mins + block * 8;
+        const float* blockMaxs = maxs + block * 8;
+        __m128 min = _mm_min_ps(_mm_loadu_ps(blockMins), _mm_loadu_ps(blockMins + 4));
+        __m128 max = _mm_max_ps(_mm_loadu_ps(blockMaxs), _mm_loadu_ps(blockMaxs + 4));
+        // Horizontal reduction of the 4 lanes
+        min = _mm_min_ps(min, _mm_shuffle_ps(min, min, _MM_SHUFFLE(1, 0, 3, 2)));
+        max = _mm_max_ps(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(1, 0, 3, 2)));
+        min = _mm_min_ps(min, _mm_shuffle_ps(min, min, _MM_SHUFFLE(2, 3, 0, 1)));
+        max = _mm_max_ps(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(2, 3, 0, 1)));
+        outMins[block] = _mm_cvtss_f32(min);
+        outMaxs[block] = _mm_cvtss_f32(max);
+    }
+#else
+    for (size_t block = 0; block < blocks; block++) {
+        outMins[block] = *std::min_element(mins + block * 8, mins + block * 8 + 8);
+        outMaxs[block] = *std::max_element(maxs + block * 8, maxs + block * 8 + 8);
+    }
+#endif
+}
+
+} // namespace
+
+void TimeSeries::push(float value) {
+    samples.push_back(value);
+    if (samples.size() % branchFactor == 0)
+        summarize();
+}
+
+void TimeSeries::append(const float* values, size_t count) {
+    samples.insert(samples.end(), values, values + count);
+    summarize();
+}
+
+void TimeSeries::clear() {
+    samples.clear();
+    levels.clear();
+}
+
+void TimeSeries::reserve(size_t count) {
+    samples.reserve(count);
+    for (size_t level = 0; count >= branchFactor; level++) {
+        if (levels.size() <= level)
+            levels.emplace_back();
+        count /= branchFactor;
+        levels[level].mins.reserve(count);
+        levels[level].maxs.reserve(count);
+    }
+}
+
+size_t TimeSeries::memoryBytes() const {
+    size_t bytes = samples.capacity() * sizeof(float);
+    for (const auto& level : levels)
+        bytes += (level.mins.capacity() + level.maxs.capacity()) * sizeof(float);
+    return bytes;
+}
+
+void TimeSeries::summarize() {
+    // Level 0 is the raw samples, where min and max are the same thing
+    const float* mins = samples.data();
+    const float* maxs = samples.data();
+    size_t count = samples.size();
+    for (size_t level = 0; count >= branchFactor; level++) {
+        if (levels.size() <= level)
+            levels.emplace_back();
+        auto& next = levels[level];
+        const size_t complete = count / branchFactor;
+        const size_t done = next.mins.size();
+        if (done == complete)
+            break; // Nothing new here means nothing new above either
+
+        next.mins.resize(complete);
+        next.maxs.resize(complete);
+        reduceBlocks(
+            mins + done * branchFactor, maxs + done * branchFactor, complete - done,
+            next.mins.data() + done, next.maxs.data() + done
+        );
+        mins = next.mins.data();
+        maxs = next.maxs.data();
+        count = complete;
+    }
+}
+
+void TimeSeries::tailMinMax(size_t begin, float& min, float& max) const {
+    min = std::numeric_limits<float>::infinity();
+    max = -std::numeric_limits<float>::infinity();
+
+    // Whole entries from the coarsest level down, then the loose samples
+    size_t position = begin;
+    size_t span = 1;
+    for (size_t level = 0; level < levels.size(); level++)
+        span *= branchFactor;
+    for (size_t level = levels.size(); level-- > 0; span /= branchFactor) {
+        const auto& entries = levels[level];
+        for (size_t entry = position / span; entry < entries.mins.size(); entry++) {
+            min = std::min(min, entries.mins[entry]);
+            max = std::max(max, entries.maxs[entry]);
+            position = (entry + 1) * span;
+        }
+    }
+    for (; position < samples.size(); position++) {
+        min = std::min(min, samples[position]);
+        max = std::max(max, samples[position]);
+    }
+}
+
+size_t TimeSeries::query(size_t first, size_t count, size_t maxPoints, float* mins, float* maxs) const {
+    if (first >= samples.size() || count == 0 || maxPoints == 0)
+        return 0;
+    const size_t last = std::min(first + count, samples.size()) - 1;
+
+    // Finest level that fits, or the coarsest one there is
+    size_t level = 0;
+    size_t span = 1;
+    while (last / span - first / span + 1 > maxPoints && level < levels.size()) {
+        level++;
+        span *= branchFactor;
+    }
+
+    size_t points = 0;
+    for (size_t entry = first / span; entry <= last / span && points < maxPoints; entry++, points++) {
+        if (level == 0) {
+            mins[points] = maxs[points] = samples[entry];
+            continue;
+        }
+        const auto& entries = levels[level - 1];
+        if (entry < entries.mins.size()) {
+            mins[points] = entries.mins[entry];
+            maxs[points] = entries.maxs[entry];
+        } else {
+            tailMinMax(entry * span, mins[points], maxs[points]);
+        }
+    }
+    return points;
+}
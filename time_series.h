@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Append-only series of float samples with min/max pyramids on top. Every
+// summary level reduces branchFactor entries of the level below into one,
+// so a range of any length can be plotted from the finest level that still
+// fits the requested number of points, without touching every sample.
+//
+// Memory: 4 bytes per sample for the samples themselves plus 8 bytes (min and
+// max) per summary entry, which adds 8/7 bytes per sample with a branch factor
+// of 8. One million samples (about 4.6 hours at 60 FPS) take 5.1 MB, plus up to
+// as much again in vector growth slack.
+struct TimeSeries {
+    public:
+    static constexpr size_t branchFactor = 8;
+
+    void push(float value);
+    void append(const float* values, size_t count);
+    void clear();
+    // Makes room for `count` samples and their summaries, so pushing up to
+    // that many never allocates
+    void reserve(size_t count);
+
+    [[nodiscard]] size_t size() const { return samples.size(); }
+    [[nodiscard]] float latest() const { return samples.empty() ? 0.0f : samples.back(); }
+    // Allocated bytes, including growth slack
+    [[nodiscard]] size_t memoryBytes() const;
+
+    // Writes the min/max envelope of samples [first, first + count) as at most
+    // maxPoints buckets and returns how many were written. Buckets are aligned
+    // to the level they come from, so the first one may reach before `first`.
+    size_t query(size_t first, size_t count, size_t maxPoints, float* mins, float* maxs) const;
+
+    private:
+    struct Level {
+        std::vector<float> mins;
+        std::vector<float> maxs;
+    };
+
+    // Summarizes blocks that were completed since the last call
+    void summarize();
+    // Min/max of samples [begin, size()), begin must start an incomplete entry
+    void tailMinMax(size_t begin, float& min, float& max) const;
+
+    std::vector<float> samples;
+    std::vector<Level> levels; // levels[i] entries cover branchFactor^(i + 1) samples
+};
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// Decodes segment files written by Trace into text or CSV:
+//   trace_decode [--csv] [--event NAME] trace.0.bin trace.1.bin ...
+// Segments are ordered by their sequence number, not by file name.
+
+struct Schema {
+    std::string name;
+    std::vector<TraceType> types;
+    std::vector<std::string> fieldNames;
+};
+
+struct Segment {
+    std::string path;
+    TraceSegmentHeader header;
+    std::vector<char> data;
+};
+
+bool readSegment(const char* path, Segment& segment) {
+    auto stream = std::ifstream(path, std::ios::binary);
+    if (!stream) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    segment.path = path;
+    segment.data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    if (segment.data.size() < sizeof(TraceSegmentHeader)) {
+        std::cerr << path << " is too small to be a trace segment" << std::endl;
+        return false;
+    }
+    std::memcpy(&segment.header, segment.data.data(), sizeof(segment.header));
+    if (std::memcmp(segment.header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || segment.header.version != TRACE_VERSION) {
+        std::cerr << path << " is not a version " << TRACE_VERSION << " trace segment" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Schema parseSchema(const char* payload, size_t size, uint16_t& event) {
+    Schema schema;
+    size_t offset = 0;
+    auto readString = [&]() {
+        uint8_t length = offset < size ? payload[offset] : 0;
+        offset++;
+        length = static_cast<uint8_t>(std::min<size_t>(length, size - std::min(offset, size)));
+        auto string = std::string(payload + offset, length);
+        offset += length;
+        return string;
+    };
+
+    // Event id and field count come first
+    if (size < 3)
+        return schema;
+    std::memcpy(&event, payload, sizeof(event));
+    uint8_t fieldCount = payload[2];
+    offset = 3;
+    schema.name = readString();
+    for (uint8_t i = 0; i < fieldCount && offset < size; i++) {
+        schema.types.push_back(static_cast<TraceType>(payload[offset++]));
+        schema.fieldNames.push_back(readString());
+    }
+    return schema;
+}
+
+void printValue(std::ostream& out, TraceType type, const char* data) {
+    switch (type) {
+        case TraceType::U32: { uint32_t v; std::memcpy(&v, data, 4); out << v; break; }
+        case TraceType::I32: { int32_t v; std::memcpy(&v, data, 4); out << v; break; }
+        case TraceType::U64: { uint64_t v; std::memcpy(&v, data, 8); out << v; break; }
+        case TraceType::I64: { int64_t v; std::memcpy(&v, data, 8); out << v; break; }
+        case TraceType::F32: { float v; std::memcpy(&v, data, 4); out << v; break; }
+        case TraceType::F64: { double v; std::memcpy(&v, data, 8); out << v; break; }
+    }
+}
+
+int main(int argc, char** argv) {
+    bool csv = false;
+    std::string filter;
+    std::vector<Segment> segments;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (std::strcmp(argv[i], "--event") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            Segment segment;
+            if (!readSegment(argv[i], segment))
+                return 1;
+            segments.push_back(std::move(segment));
+        }
+    }
+    if (segments.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--csv] [--event NAME] SEGMENT..." << std::endl;
+        return 1;
+    }
+
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.header.sequence < b.header.sequence;
+    });
+
+    std::map<uint16_t, Schema> schemas;
+    auto& out = std::cout;
+    bool headerPrinted = false;
+    if (csv && filter.empty()) {
+        out << "timestamp_ns,event,field,value\n";
+        headerPrinted = true;
+    }
+
+    for (auto& segment : segments) {
+        const char* data = segment.data.data();
+        size_t offset = segment.header.headerSize;
+        while (offset + sizeof(TraceRecordHeader) <= segment.data.size()) {
+            TraceRecordHeader record = {};
+            std::memcpy(&record, data + offset, sizeof(record));
+            if (record.event == TRACE_EVENT_END)
+                break;
+            const char* payload = data + offset + sizeof(record);
+            offset += (sizeof(record) + record.size + 7) & ~size_t(7);
+            if (offset > segment.data.size()) {
+                std::cerr << segment.path << ": truncated record" << std::endl;
+                break;
+            }
+
+            if (record.event == TRACE_EVENT_SCHEMA) {
+                if (record.size < 3) {
+                    std::cerr << segment.path << ": truncated record" << std::endl;
+                    continue;
+                }
+                uint16_t event = {};
+                auto schema = parseSchema(payload, record.size, event);
+                schemas[event] = std::move(schema);
+                continue;
+            }
+
+            auto found = schemas.find(record.event);
+            if (found == schemas.end()) {
+                std::cerr << segment.path << ": event " << record.event << " has no schema" << std::endl;
+                continue;
+            }
+            auto& schema = found->second;
+            if (!filter.empty() && schema.name != filter)
+                continue;
+
+            const int64_t timestamp = record.timestamp - segment.header.startTime;
+            const char* value = payload;
+            const char* end = payload + record.size;
+
+            if (csv && filter.empty()) {
+                for (size_t i = 0; i < schema.types.size() && value + traceTypeSize(schema.types[i]) <= end; i++) {
+                    out << timestamp << ',' << schema.name << ',' << schema.fieldNames[i] << ',';
+                    printValue(out, schema.types[i], value);
+                    out << '\n';
+                    value += traceTypeSize(schema.types[i]);
+                }
+            } else if (csv) {
+                if (!headerPrinted) {
+                    out << "timestamp_ns";
+                    for (auto& name : schema.fieldNames) out << ',' << name;
+                    out << '\n';
+                    headerPrinted = true;
+                }
+                out << timestamp;
+                for (size_t i = 0; i < schema.types.size() && value + traceTypeSize(schema.types[i]) <= end; i++) {
+                    out << ',';
+                    printValue(out, schema.types[i], value);
+                    value += traceTypeSize(schema.types[i]);
+                }
+                out << '\n';
+            } else {
+                char time[32];
+                std::snprintf(time, sizeof(time), "%12.6f", timestamp / 1e9);
+                out << time << ' ' << schema.name;
+                for (size_t i = 0; i < schema.types.size() && value + traceTypeSize(schema.types[i]) <= end; i++) {
+                    out << ' ' << schema.fieldNames[i] << '=';
+                    printValue(out, schema.types[i], value);
+                    value += traceTypeSize(schema.types[i]);
+                }
+                out << '\n';
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "trace.h"
+#include "logs.h"
+
+namespace {
+
+constexpr size_t recordAlignment = 8;
+// Segments are unmapped this many rotations after they were retired, by then
+// no writer can still be holding a pointer into them. Files are reused after
+// retiredSegmentsKept + 1 rotations, once their segment has been unmapped.
+constexpr size_t retiredSegmentsKept = 2;
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+struct TraceSegment {
+    char* base = nullptr;
+    size_t capacity = 0;
+    std::atomic<size_t> reserved = sizeof(TraceSegmentHeader);
+};
+
+struct EventSchema {
+    std::string name;
+    std::vector<TraceField> fields;
+    std::vector<std::string> fieldNames;
+};
+
+struct TraceState {
+    std::mutex mutex; // Guards everything except current
+    std::atomic<TraceSegment*> current = nullptr;
+    std::vector<TraceSegment*> retired;
+    std::vector<EventSchema> schemas;
+    std::string prefix;
+    size_t segmentSize = 0;
+    unsigned int maxSegments = 0;
+    uint64_t sequence = 0;
+    int64_t startTime = 0;
+};
+
+TraceState& state() {
+    static TraceState instance;
+    return instance;
+}
+
+// Reserves space in the segment and fills it in. Returns false when it does not fit.
+bool append(TraceSegment* segment, int64_t timestamp, uint16_t event, const void* payload, uint16_t size) {
+    const size_t total = alignUp(sizeof(TraceRecordHeader) + size, recordAlignment);
+    const size_t offset = segment->reserved.fetch_add(total, std::memory_order_relaxed);
+    if (offset + total > segment->capacity)
+        return false;
+
+    TraceRecordHeader header = {timestamp, event, size, 0};
+    std::memcpy(segment->base + offset + sizeof(header), payload, size);
+    std::memcpy(segment->base + offset, &header, sizeof(header));
+    return true;
+}
+
+std::vector<char> encodeSchema(uint16_t event, const EventSchema& schema) {
+    std::vector<char> payload;
+    auto put = [&payload](const void* data, size_t size) {
+        auto bytes = static_cast<const char*>(data);
+        payload.insert(payload.end(), bytes, bytes + size);
+    };
+    auto putString = [&](const std::string& string) {
+        uint8_t length = static_cast<uint8_t>(std::min<size_t>(string.size(), UINT8_MAX));
+        put(&length, 1);
+        put(string.data(), length);
+    };
+
+    uint8_t fieldCount = static_cast<uint8_t>(schema.fields.size());
+    put(&event, sizeof(event));
+    put(&fieldCount, 1);
+    putString(schema.name);
+    for (size_t i = 0; i < schema.fields.size(); i++) {
+        put(&schema.fields[i].type, 1);
+        putString(schema.fieldNames[i]);
+    }
+    return payload;
+}
+
+// Must be called with the mutex held
+TraceSegment* openSegment(TraceState& s) {
+    auto path = s.prefix + "." + std::to_string(s.sequence % s.maxSegments) + ".bin";
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error("Could not open trace file " << path);
+        return nullptr;
+    }
+    if (ftruncate(fd, s.segmentSize) != 0) {
+        error("Could not resize trace file " << path);
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, s.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error("Could not map trace file " << path);
+        return nullptr;
+    }
+
+    auto segment = new TraceSegment();
+    segment->base = static_cast<char*>(mapping);
+    segment->capacity = s.segmentSize;
+
+    TraceSegmentHeader header = {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.headerSize = sizeof(header);
+    header.sequence = s.sequence++;
+    header.capacity = s.segmentSize;
+    header.startTime = s.startTime;
+    std::memcpy(segment->base, &header, sizeof(header));
+
+    // Every segment is self-describing, so old ones can be dropped by rotation
+    for (size_t i = 0; i < s.schemas.size(); i++) {
+        auto event = static_cast<uint16_t>(TRACE_FIRST_EVENT + i);
+        auto payload = encodeSchema(event, s.schemas[i]);
+        append(segment, s.startTime, TRACE_EVENT_SCHEMA, payload.data(), static_cast<uint16_t>(payload.size()));
+    }
+
+    return segment;
+}
+
+void unmapSegment(TraceSegment* segment) {
+    munmap(segment->base, segment->capacity);
+    delete segment;
+}
+
+TraceSegment* rotate(TraceSegment* full) {
+    auto& s = state();
+    std::lock_guard lock(s.mutex);
+    auto segment = s.current.load(std::memory_order_acquire);
+    if (segment != full)
+        return segment; // Another thread got here first
+
+    // Unmapped before the next file is opened, which may be the same one
+    if (full)
+        s.retired.push_back(full);
+    while (s.retired.size() > retiredSegmentsKept) {
+        unmapSegment(s.retired.front());
+        s.retired.erase(s.retired.begin());
+    }
+
+    auto next = openSegment(s);
+    s.current.store(next, std::memory_order_release);
+    return next;
+}
+
+} // namespace
+
+bool Trace::open(const char* prefix, size_t segmentSize, unsigned int maxSegments) {
+    auto& s = state();
+    std::lock_guard lock(s.mutex);
+    if (s.current.load(std::memory_order_relaxed)) {
+        error("Trace is already open");
+        return false;
+    }
+
+    s.prefix = prefix;
+    s.segmentSize = std::max(segmentSize, sizeof(TraceSegmentHeader) + 4096);
+    s.maxSegments = std::max(maxSegments, static_cast<unsigned int>(retiredSegmentsKept + 1));
+    s.sequence = 0;
+    s.startTime = now();
+
+    auto segment = openSegment(s);
+    if (!segment)
+        return false;
+    s.current.store(segment, std::memory_order_release);
+    return true;
+}
+
+void Trace::close() {
+    auto& s = state();
+    std::lock_guard lock(s.mutex);
+    auto segment = s.current.exchange(nullptr, std::memory_order_acq_rel);
+    if (segment)
+        s.retired.push_back(segment);
+    for (auto retired : s.retired)
+        unmapSegment(retired);
+    s.retired.clear();
+}
+
+bool Trace::isOpen() {
+    return state().current.load(std::memory_order_relaxed) != nullptr;
+}
+
+uint16_t Trace::registerEvent(const char* name, const TraceField* fields, size_t fieldCount) {
+    auto& s = state();
+    uint16_t event = {};
+    std::vector<char> payload;
+    {
+        std::lock_guard lock(s.mutex);
+        EventSchema schema = {name, {}, {}};
+        for (size_t i = 0; i < fieldCount; i++) {
+            schema.fields.push_back(fields[i]);
+            schema.fieldNames.emplace_back(fields[i].name);
+        }
+        event = static_cast<uint16_t>(TRACE_FIRST_EVENT + s.schemas.size());
+        payload = encodeSchema(event, schema);
+        s.schemas.push_back(std::move(schema));
+    }
+
+    // A segment opened in the meantime may carry the schema already, the decoder
+    // accepts duplicates
+    write(TRACE_EVENT_SCHEMA, payload.data(), static_cast<uint16_t>(payload.size()));
+    return event;
+}
+
+void Trace::write(uint16_t event, const void* payload, uint16_t size) {
+    auto& s = state();
+    auto segment = s.current.load(std::memory_order_acquire);
+    if (!segment)
+        return;
+
+    const int64_t timestamp = now();
+    while (!append(segment, timestamp, event, payload, size)) {
+        segment = rotate(segment);
+        if (!segment)
+            return;
+    }
+}
+
+int64_t Trace::now() {
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    return duration_cast<nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+// Compact binary event log. Every record is a timestamp, an event id and a
+// small payload whose layout is described by a schema registered up front.
+// Records are appended to memory-mapped segment files that rotate once full,
+// see tools/trace_decode.cpp for turning them back into text or CSV.
+//
+// Segment layout (little endian, records aligned to 8 bytes):
+//   TraceSegmentHeader
+//   TraceRecordHeader + payload, ...
+//   zeroes (unused space, a zero event id marks the end)
+
+const char TRACE_MAGIC[8] = {'G', 'L', 'T', 'R', 'A', 'C', 'E', '\0'};
+const uint32_t TRACE_VERSION = 1;
+
+// Reserved event ids, registered events start after these
+const uint16_t TRACE_EVENT_END = 0;
+const uint16_t TRACE_EVENT_SCHEMA = 1;
+const uint16_t TRACE_FIRST_EVENT = 2;
+
+enum class TraceType : uint8_t {
+    U32,
+    I32,
+    U64,
+    I64,
+    F32,
+    F64,
+};
+
+struct TraceSegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sequence;
+    uint64_t capacity;
+    int64_t startTime; // Nanoseconds, same clock as the record timestamps
+    uint8_t reserved[24];
+};
+static_assert(sizeof(TraceSegmentHeader) == 64);
+
+struct TraceRecordHeader {
+    int64_t timestamp;
+    uint16_t event;
+    uint16_t size; // Payload bytes, the record is padded to 8 bytes after that
+    uint32_t reserved;
+};
+static_assert(sizeof(TraceRecordHeader) == 16);
+
+// Schema records carry: u16 event id, u8 field count, u8 name length, name,
+// then for every field u8 TraceType, u8 name length, name.
+
+struct TraceField {
+    const char* name;
+    TraceType type;
+};
+
+template<typename T>
+constexpr TraceType traceTypeOf() {
+    if constexpr (std::is_same_v<T, float>) return TraceType::F32;
+    else if constexpr (std::is_same_v<T, double>) return TraceType::F64;
+    else if constexpr (std::is_integral_v<T> && sizeof(T) <= 4) return std::is_signed_v<T> ? TraceType::I32 : TraceType::U32;
+    else if constexpr (std::is_integral_v<T> && sizeof(T) == 8) return std::is_signed_v<T> ? TraceType::I64 : TraceType::U64;
+    else static_assert(sizeof(T) == 0, "Unsupported trace field type");
+}
+
+constexpr size_t traceTypeSize(TraceType type) {
+    return type == TraceType::U32 || type == TraceType::I32 || type == TraceType::F32 ? 4 : 8;
+}
+
+struct Trace {
+    public:
+    // Opens <prefix>.0.bin ... <prefix>.<maxSegments - 1>.bin, reusing them in
+    // turn. maxSegments is raised to at least 3, so a file is only reused once
+    // its last mapping is gone.
+    static bool open(const char* prefix, size_t segmentSize = 16 << 20, unsigned int maxSegments = 4);
+    // Unmaps everything right away, writers get no grace period. Call it from
+    // the main thread after joining every other thread that writes events.
+    static void close();
+    [[nodiscard]] static bool isOpen();
+
+    static uint16_t registerEvent(const char* name, const TraceField* fields, size_t fieldCount);
+    static uint16_t registerEvent(const char* name, std::initializer_list<TraceField> fields) {
+        return registerEvent(name, fields.begin(), fields.size());
+    }
+    // Appends a record, a no-op when the trace is not open
+    static void write(uint16_t event, const void* payload, uint16_t size);
+    // Timestamp source used for records
+    static int64_t now();
+};
+
+// Typed event, the schema is derived from the argument types:
+//   static TraceEvent<uint32_t, float> frameEvent("frame", {"index", "cpuMs"});
+//   frameEvent(index, cpuMs);
+template<typename... Fields>
+struct TraceEvent {
+    public:
+    TraceEvent(const char* name, std::array<const char*, sizeof...(Fields)> fieldNames) {
+        constexpr TraceType types[] = {traceTypeOf<Fields>()..., TraceType::U32};
+        TraceField fields[sizeof...(Fields) + 1] = {};
+        for (size_t i = 0; i < sizeof...(Fields); i++)
+            fields[i] = {fieldNames[i], types[i]};
+        id = Trace::registerEvent(name, fields, sizeof...(Fields));
+    }
+
+    void operator()(Fields... values) const {
+        char payload[(traceTypeSize(traceTypeOf<Fields>()) + ... + 0) + 1];
+        size_t offset = 0;
+        ((pack(payload, offset, values)), ...);
+        Trace::write(id, payload, static_cast<uint16_t>(offset));
+    }
+
+    [[nodiscard]] uint16_t getId() const { return id; }
+
+    private:
+    template<typename T>
+    static void pack(char* payload, size_t& offset, T value) {
+        constexpr TraceType type = traceTypeOf<T>();
+        if constexpr (type == TraceType::U32) { uint32_t v = value; std::memcpy(payload + offset, &v, 4); }
+        else if constexpr (type == TraceType::I32) { int32_t v = value; std::memcpy(payload + offset, &v, 4); }
+        else if constexpr (type == TraceType::U64) { uint64_t v = value; std::memcpy(payload + offset, &v, 8); }
+        else if constexpr (type == TraceType::I64) { int64_t v = value; std::memcpy(payload + offset, &v, 8); }
+        else std::memcpy(payload + offset, &value, sizeof(value));
+        offset += traceTypeSize(type);
+    }
+
+    uint16_t id = TRACE_EVENT_END;
+};
@@ -0,0 +1,66 @@
+#include "ui_cache.h"
+#include "gl_debug.h"
+#include "logs.h"
+
+UiCache::~UiCache() {
+    destroy();
+}
+
+bool UiCache::init(const char* vertexSource, const char* fragmentSource) {
+    if (!program.registerShader(vertexSource, Program::ShaderType::Vertex))
+        return false;
+    if (!program.registerShader(fragmentSource, Program::ShaderType::Fragment))
+        return false;
+    if (!program.registerProgram())
+        return false;
+    labelGlObject(GL_PROGRAM, program.getId(), "ui composite program");
+    uvScaleLocation = glGetUniformLocation(program.getId(), "uvScale");
+
+    target.init("ui cache");
+    // Core profile needs a bound VAO even though the triangle has no attributes
+    vertexArray = gpuResources().create<GpuResourceType::VertexArray>();
+    return true;
+}
+
+void UiCache::destroy() {
+    target.destroy();
+    vertexArray.reset();
+    program.destroy();
+}
+
+bool UiCache::needsUpdate(double now, int refreshRate) const {
+    return dirty || (refreshRate > 0 && now - lastUpdate >= 1.0 / refreshRate);
+}
+
+void UiCache::beginRender(GlState& gl, int width, int height) {
+    target.resize(gl, width, height);
+    gl.bindFramebuffer(GL_FRAMEBUFFER, target.getFramebuffer());
+    glViewport(0, 0, width, height);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void UiCache::endRender(GlState& gl, double now) {
+    gl.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    dirty = false;
+    lastUpdate = now;
+}
+
+void UiCache::composite(GlState& gl) {
+    if (target.getWidth() == 0 || target.getHeight() == 0)
+        return;
+
+    // ImGui blended into transparent black, so the texture holds premultiplied colors
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    gl.useProgram(program.getId());
+    glUniform2f(uvScaleLocation, target.getUScale(), target.getVScale());
+    gl.bindVertexArray(vertexArray.id());
+    gl.activeTexture(GL_TEXTURE0);
+    gl.bindTexture(GL_TEXTURE_2D, target.getTexture());
+    gl.drawArrays(GL_TRIANGLES, 0, 3);
+
+    glDisable(GL_BLEND);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+#include "program.h"
+#include "render_target.h"
+
+// Keeps the rendered UI in a texture. ImGui only has to build and render a new
+// frame when input arrived, something marked the UI dirty or the refresh
+// interval ran out; every other frame just composites one full-screen triangle.
+struct UiCache {
+    public:
+    UiCache() = default;
+    ~UiCache();
+    UiCache(const UiCache&) = delete;
+    UiCache& operator=(const UiCache&) = delete;
+
+    bool init(const char* vertexSource, const char* fragmentSource);
+    // Must run while the GL context is still alive
+    void destroy();
+
+    void markDirty() { dirty = true; }
+    // refreshRate is in Hz, 0 refreshes on input and markDirty() only
+    [[nodiscard]] bool needsUpdate(double now, int refreshRate) const;
+
+    // UI rendered between these goes into the cached texture
+    void beginRender(GlState& gl, int width, int height);
+    void endRender(GlState& gl, double now);
+    // Blends the cached texture over the currently bound framebuffer
+    void composite(GlState& gl);
+
+    private:
+    Program program;
+    GLint uvScaleLocation = -1;
+    RenderTarget target;
+    GpuVertexArray vertexArray;
+    bool dirty = true;
+    double lastUpdate = 0;
+};
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "upload_manager.h"
+#include "gl_debug.h"
+#include "logs.h"
+#include "stats.h"
+
+namespace {
+
+constexpr size_t minimumStagingSize = 256 << 10;
+
+constexpr size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void UploadManager::destroy() {
+    staging.reset();
+    stagingCapacity = 0;
+    pending.clear();
+    data.clear();
+}
+
+void UploadManager::queue(const Upload& upload, const void* bytes) {
+    const auto source = static_cast<const unsigned char*>(bytes);
+    // Writes continuing the previous one are merged right away, the common case
+    if (!pending.empty() && !upload.texture) {
+        auto& last = pending.back();
+        if (!last.texture && last.target == upload.target && last.urgent == upload.urgent
+            && last.offset + last.size == upload.offset && last.data + last.size == data.size()) {
+            last.size += upload.size;
+            data.insert(data.end(), source, source + upload.size);
+            return;
+        }
+    }
+    pending.push_back(upload);
+    pending.back().data = data.size();
+    data.insert(data.end(), source, source + upload.size);
+}
+
+void UploadManager::queueBuffer(GLuint buffer, size_t offset, const void* bytes, size_t size, bool urgent) {
+    if (size == 0)
+        return;
+    Upload upload = {};
+    upload.target = buffer;
+    upload.urgent = urgent;
+    upload.offset = offset;
+    upload.size = size;
+    queue(upload, bytes);
+}
+
+void UploadManager::queueTexture(
+    GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+    size_t bytesPerPixel, const void* bytes, bool urgent
+) {
+    if (width <= 0 || height <= 0)
+        return;
+    Upload upload = {};
+    upload.target = texture;
+    upload.texture = true;
+    upload.urgent = urgent;
+    upload.size = static_cast<size_t>(width) * height * bytesPerPixel;
+    upload.x = x;
+    upload.y = y;
+    upload.width = width;
+    upload.height = height;
+    upload.format = format;
+    upload.type = type;
+    queue(upload, bytes);
+}
+
+void UploadManager::reserveStaging(GlState& gl, size_t size) {
+    if (staging && size <= stagingCapacity)
+        return;
+    stagingCapacity = std::max({size, stagingCapacity * 2, minimumStagingSize});
+    if (!staging)
+        staging = gpuResources().create<GpuResourceType::Buffer>();
+    staging.setMemory(stagingCapacity);
+    gl.bindBuffer(GL_COPY_READ_BUFFER, staging.id());
+    glBufferData(GL_COPY_READ_BUFFER, stagingCapacity, nullptr, GL_STREAM_DRAW);
+    labelGlObject(GL_BUFFER, staging.id(), "upload staging");
+    debug("Upload staging buffer grown to " << stagingCapacity / 1024 << " KiB");
+}
+
+void UploadManager::flush(GlState& gl) {
+    const auto start = std::chrono::steady_clock::now();
+    lastStats.bytes = 0;
+    lastStats.uploads = 0;
+    lastStats.calls = 0;
+    lastStats.cpuMs = 0;
+
+    // Non urgent updates go out in queue order until the budget is spent, the
+    // first one always goes however large. A held back update still goes when
+    // a later urgent one has the same target, or it would overwrite that later.
+    batch.clear();
+    size_t budgetUsed = 0;
+    bool holding = false;
+    for (size_t i = 0; i < pending.size(); i++) {
+        bool take = pending[i].urgent;
+        if (!take && !holding) {
+            take = budget == 0 || budgetUsed == 0 || budgetUsed + pending[i].size <= budget;
+            holding = !take;
+            if (take)
+                budgetUsed += pending[i].size;
+        }
+        for (size_t j = i + 1; j < pending.size() && !take; j++)
+            take = pending[j].urgent && pending[j].target == pending[i].target && pending[j].texture == pending[i].texture;
+        if (take)
+            batch.push_back(pending[i]);
+    }
+    if (batch.empty()) {
+        lastStats.pendingBytes = data.size();
+        return;
+    }
+
+    // Buffer writes sorted by destination, so adjacent ones sit next to each
+    // other in the staging buffer and can be merged. Overlapping writes keep
+    // queue order instead.
+    auto collectCopies = [this](bool byOffset) {
+        copies.clear();
+        for (const auto& upload : batch) {
+            if (!upload.texture)
+                copies.push_back(upload);
+        }
+        std::stable_sort(copies.begin(), copies.end(), [byOffset](const Upload& a, const Upload& b) {
+            if (a.target != b.target)
+                return a.target < b.target;
+            return byOffset && a.offset < b.offset;
+        });
+    };
+    collectCopies(true);
+    for (size_t i = 1; i < copies.size(); i++) {
+        if (copies[i].target == copies[i - 1].target && copies[i - 1].offset + copies[i - 1].size > copies[i].offset) {
+            collectCopies(false);
+            break;
+        }
+    }
+
+    size_t total = 0;
+    for (auto& copy : copies) {
+        copy.staging = total;
+        total += copy.size;
+    }
+    for (auto& upload : batch) {
+        if (upload.texture) {
+            upload.staging = alignUp(total, stagingAlignment);
+            total = upload.staging + upload.size;
+        }
+    }
+
+    reserveStaging(gl, total);
+    gl.bindBuffer(GL_COPY_READ_BUFFER, staging.id());
+    auto mapping = static_cast<unsigned char*>(
+        glMapBufferRange(GL_COPY_READ_BUFFER, 0, total, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+    );
+    if (mapping) {
+        for (const auto& copy : copies)
+            std::memcpy(mapping + copy.staging, data.data() + copy.data, copy.size);
+        for (const auto& upload : batch) {
+            if (upload.texture)
+                std::memcpy(mapping + upload.staging, data.data() + upload.data, upload.size);
+        }
+    }
+    // Contents can be lost while mapped, for example on a mode switch
+    if (!mapping || !glUnmapBuffer(GL_COPY_READ_BUFFER)) {
+        warning_throttled(LogCategory::GL, "Could not fill the upload staging buffer, retrying next frame");
+        lastStats.pendingBytes = data.size();
+        return;
+    }
+
+    size_t merged = 0;
+    for (size_t i = 0; i < copies.size(); i++) {
+        if (merged > 0) {
+            auto& previous = copies[merged - 1];
+            if (previous.target == copies[i].target && previous.offset + previous.size == copies[i].offset
+                && previous.staging + previous.size == copies[i].staging) {
+                previous.size += copies[i].size;
+                continue;
+            }
+        }
+        copies[merged++] = copies[i];
+    }
+    copies.resize(merged);
+    for (const auto& copy : copies) {
+        gl.bindBuffer(GL_COPY_WRITE_BUFFER, copy.target);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy.staging, copy.offset, copy.size);
+        lastStats.calls++;
+    }
+
+    bool textures = false;
+    for (const auto& upload : batch) {
+        if (!upload.texture)
+            continue;
+        if (!textures) {
+            gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.id());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            textures = true;
+        }
+        gl.bindTexture(GL_TEXTURE_2D, upload.target);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, upload.x, upload.y, upload.width, upload.height, upload.format, upload.type,
+            reinterpret_cast<const void*>(upload.staging)
+        );
+        lastStats.calls++;
+    }
+    // Leave client memory texture uploads (the stock ImGui backend) working
+    if (textures) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    for (const auto& upload : batch)
+        lastStats.bytes += upload.size;
+    lastStats.uploads = static_cast<uint32_t>(batch.size());
+    lastStats.totalBytes += lastStats.bytes;
+    auto& counters = frameCounters();
+    counters.uploadCalls += lastStats.calls;
+    counters.bytesUploaded += lastStats.bytes;
+
+    // Keep what was held back, in order
+    if (batch.size() == pending.size()) {
+        pending.clear();
+        data.clear();
+    } else {
+        remainingData.clear();
+        size_t kept = 0;
+        size_t next = 0; // Pending entries were taken in order, the batch is a subsequence
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (next < batch.size() && batch[next].data == pending[i].data) {
+                next++;
+                continue;
+            }
+            const size_t offset = remainingData.size();
+            remainingData.insert(
+                remainingData.end(), data.begin() + pending[i].data, data.begin() + pending[i].data + pending[i].size
+            );
+            pending[kept] = pending[i];
+            pending[kept].data = offset;
+            kept++;
+        }
+        pending.resize(kept);
+        data.swap(remainingData);
+    }
+    lastStats.pendingBytes = data.size();
+    lastStats.cpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gpu_resources.h"
+
+// Collects the buffer and texture updates of a frame and issues them together
+// in flush(): the data is packed into one staging buffer with a single
+// mapping, then copied into place with glCopyBufferSubData, or
+// glTexSubImage2D from the staging buffer bound as the pixel unpack buffer.
+// Updates of adjacent ranges of the same buffer become one copy.
+//
+// Data is copied when queued, so the caller's memory (frame arena included)
+// may go away right after. Non urgent updates are held back once the frame's
+// byte budget is spent and go out in later frames, in queue order. Targets
+// must stay alive and in place until then.
+struct UploadManager {
+    public:
+    struct Stats {
+        size_t bytes; // Last flush
+        uint32_t uploads; // Queued updates in the last flush
+        uint32_t calls; // GL copies issued for them
+        size_t pendingBytes; // Held back by the budget
+        float cpuMs; // Packing and issuing the last flush
+        uint64_t totalBytes; // Since startup
+    };
+
+    UploadManager() = default;
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    // Must run while the GL context is still alive
+    void destroy();
+
+    // 0 for no limit, urgent updates always go out with the next flush
+    void setBudget(size_t bytesPerFrame) { budget = bytesPerFrame; }
+
+    void queueBuffer(GLuint buffer, size_t offset, const void* data, size_t size, bool urgent = true);
+    // Rows of `data` are tightly packed, with `bytesPerPixel` bytes per pixel
+    void queueTexture(
+        GLuint texture, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+        size_t bytesPerPixel, const void* data, bool urgent = true
+    );
+
+    void flush(GlState& gl);
+
+    [[nodiscard]] Stats stats() const { return lastStats; }
+
+    private:
+    // Texture data offsets in the staging buffer are aligned to this
+    static constexpr size_t stagingAlignment = 16;
+
+    struct Upload {
+        GLuint target; // Buffer or texture
+        bool texture;
+        bool urgent;
+        size_t offset; // Into the buffer
+        size_t size;
+        size_t data; // Offset into `data`
+        GLint x, y;
+        GLsizei width, height;
+        GLenum format, type;
+        size_t staging; // Offset into the staging buffer while flushing
+    };
+
+    void queue(const Upload& upload, const void* bytes);
+    void reserveStaging(GlState& gl, size_t size);
+
+    GpuBuffer staging;
+    size_t stagingCapacity = 0;
+    size_t budget = 0;
+    std::vector<Upload> pending; // Queue order
+    std::vector<unsigned char> data; // Bytes of the pending updates
+    // Reused by every flush
+    std::vector<Upload> batch;
+    std::vector<Upload> copies;
+    std::vector<unsigned char> remainingData;
+    Stats lastStats = {};
+};
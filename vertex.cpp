@@ -0,0 +1,16 @@
+#include "vertex.h"
+
+void setupVertexArray(GLuint vertexArray, GLuint vertexBuffer) {
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    // Specify position attribute -> 0 as offset
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (GLvoid *)0);
+    glEnableVertexAttribArray(0);
+
+    // Specify color attribute -> 3 as offset
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (GLvoid *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
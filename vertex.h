@@ -1,4 +1,10 @@
 #pragma once
 
+#include <glad/glad.h>
+
 const unsigned int VERTEX_ELEMENT_COUNT = 6;
 typedef float vertex[VERTEX_ELEMENT_COUNT];
+
+// Points the VAO at `vertex` records in the buffer, position at location 0 and
+// color at location 1. Leaves the VAO bound and GL_ARRAY_BUFFER unbound.
+void setupVertexArray(GLuint vertexArray, GLuint vertexBuffer);